@@ -1,4 +1,4 @@
-QT += core widgets network dbus
+QT += core widgets network dbus concurrent
 
 CONFIG += c++17
 
@@ -28,7 +28,23 @@ SOURCES += \
     src/NotificationPopupManager.cpp \
     src/ServiceDiscovery.cpp \
     src/NotificationClient.cpp \
-    src/Logger.cpp
+    src/Logger.cpp \
+    src/RetentionPolicy.cpp \
+    src/HistoryStore.cpp \
+    src/SearchIndex.cpp \
+    src/NotificationListModel.cpp \
+    src/NotificationDelegate.cpp \
+    src/NotificationListView.cpp \
+    src/NotificationCardPool.cpp \
+    src/TextLayoutCache.cpp \
+    src/RelativeTimeTicker.cpp \
+    src/UpdateBatcher.cpp \
+    src/BackgroundCache.cpp \
+    src/CardRenderer.cpp \
+    src/PopupOverlay.cpp \
+    src/FramePacer.cpp \
+    src/GroupBodiesModel.cpp \
+    src/BlobCache.cpp
 
 HEADERS += \
     src/MainWindow.h \
@@ -41,7 +57,26 @@ HEADERS += \
     src/NotificationPopupManager.h \
     src/ServiceDiscovery.h \
     src/NotificationClient.h \
-    src/Logger.h
+    src/Logger.h \
+    src/RetentionPolicy.h \
+    src/HistoryStore.h \
+    src/SearchIndex.h \
+    src/NotificationListModel.h \
+    src/NotificationDelegate.h \
+    src/NotificationListView.h \
+    src/NotificationCardPool.h \
+    src/TextLayoutCache.h \
+    src/RelativeTimeTicker.h \
+    src/UpdateBatcher.h \
+    src/BackgroundCache.h \
+    src/CardRenderer.h \
+    src/PopupOverlay.h \
+    src/FramePacer.h \
+    src/GroupBodiesModel.h \
+    src/BlobCache.h
+
+RESOURCES += \
+    resources.qrc
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -1,18 +1,27 @@
 #include "AnimationManager.h"
+#include "FramePacer.h"
+#include "Logger.h"
 #include "qwindowdefs.h"
 #include "src/NotificationPanel.h"
 
 #include <QWidget>
+#include <QLabel>
 #include <QPropertyAnimation>
 #include <QApplication>
 #include <QScreen>
 #include <QRect>
+#include <QTimer>
+#include <QElapsedTimer>
 
 AnimationManager::AnimationManager(QWidget* targetWidget, QObject *parent)
     : QObject(parent)
     , m_targetWidget(targetWidget)
-    , m_slideAnimation(nullptr)
+    , m_snapshot(nullptr)
     , m_fadeAnimation(nullptr)
+    , m_frameTimer(nullptr)
+    , m_slideStart(0)
+    , m_lastFrame(0)
+    , m_slideDuration(0)
     , m_isVisible(false)
     , m_isAnimatingOut(false)
 {
@@ -21,26 +30,30 @@ AnimationManager::AnimationManager(QWidget* targetWidget, QObject *parent)
 
 AnimationManager::~AnimationManager()
 {
-    // QObject destructor handles child objects
+    // The snapshot is a top-level window without a parent
+    delete m_snapshot;
 }
 
 void AnimationManager::setupAnimations()
 {
     if (!m_targetWidget) return;
     
-    // Setup slide animation
-    m_slideAnimation = new QPropertyAnimation(m_targetWidget, "geometry", this);
-    m_slideAnimation->setDuration(ANIMATION_DURATION);
-    m_slideAnimation->setEasingCurve(QEasingCurve::OutCubic);
+    // Snapshot window, styled like the panel window it stands in for
+    m_snapshot = new QLabel();
+    m_snapshot->setWindowFlags(m_targetWidget->windowFlags());
+    m_snapshot->setAttribute(Qt::WA_TranslucentBackground);
+    m_snapshot->setAttribute(Qt::WA_ShowWithoutActivating);
+    
+    m_clock.start();
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_frameTimer, &QTimer::timeout, this, &AnimationManager::onFrame);
     
     // Setup fade animation
     m_fadeAnimation = new QPropertyAnimation(m_targetWidget, "windowOpacity", this);
     m_fadeAnimation->setDuration(ANIMATION_DURATION);
     m_fadeAnimation->setEasingCurve(QEasingCurve::OutCubic);
     
-    // Connect signals
-    connect(m_slideAnimation, &QPropertyAnimation::finished, 
-            this, &AnimationManager::onAnimationFinished);
     connect(m_fadeAnimation, &QPropertyAnimation::finished,
             this, &AnimationManager::onAnimationFinished);
 }
@@ -50,21 +63,20 @@ void AnimationManager::slideIn()
     if (!m_targetWidget || m_isVisible) return;
     
     m_isAnimatingOut = false; // We're animating in
+    m_isVisible = true;
     
-    // Position widget off-screen first
-    QRect hiddenPos = getHiddenPosition();
     QRect visiblePos = getVisiblePosition();
+    QPoint from = getHiddenPosition().topLeft();
+    if (m_frameTimer->isActive()) {
+        // Reverse a slide-out from wherever the snapshot is now
+        from = m_snapshot->pos();
+    } else {
+        // Lay the hidden panel out at its final size and grab it once
+        m_targetWidget->setGeometry(visiblePos);
+        captureSnapshot();
+    }
     
-    m_targetWidget->setGeometry(hiddenPos);
-    m_targetWidget->show();
-    m_targetWidget->setWindowOpacity(1.0);
-    
-    // Animate sliding in
-    m_slideAnimation->setStartValue(hiddenPos);
-    m_slideAnimation->setEndValue(visiblePos);
-    m_slideAnimation->start();
-    
-    m_isVisible = true;
+    startSlide(from, visiblePos.topLeft());
 }
 
 
@@ -73,19 +85,118 @@ void AnimationManager::slideOut()
     if (!m_targetWidget || !m_isVisible) return;
     
     m_isAnimatingOut = true; // We're animating out
+    m_isVisible = false;
     
-    // Ensure the widget is visible during the animation
-    m_targetWidget->show();
+    QPoint from = m_targetWidget->pos(); // Use current position
+    if (m_frameTimer->isActive()) {
+        from = m_snapshot->pos();
+    } else {
+        captureSnapshot();
+    }
     
-    QRect visiblePos = m_targetWidget->geometry(); // Use current position
-    QRect hiddenPos = getHiddenPosition();
+    startSlide(from, getHiddenPosition().topLeft());
+}
+
+void AnimationManager::captureSnapshot()
+{
+    m_targetWidget->ensurePolished();
+    m_snapshot->setPixmap(m_targetWidget->grab());
+    m_snapshot->resize(m_targetWidget->size());
+}
+
+void AnimationManager::startSlide(const QPoint& from, const QPoint& to)
+{
+    m_slideFrom = from;
+    m_slideTo = to;
+    m_slideDuration = FramePacer::instance().duration(ANIMATION_DURATION);
+    if (m_slideDuration <= 0) {
+        // Frames are being dropped badly; jump straight to the end state
+        finishSlide();
+        return;
+    }
     
-    // Animate sliding out - widget should remain visible during animation
-    m_slideAnimation->setStartValue(visiblePos);
-    m_slideAnimation->setEndValue(hiddenPos);
-    m_slideAnimation->start();
+    // Show the snapshot before hiding the panel so nothing flickers
+    m_snapshot->move(from);
+    m_snapshot->show();
+    m_snapshot->raise();
+    m_targetWidget->hide();
     
-    m_isVisible = false;
+    m_slideStart = m_clock.elapsed();
+    m_lastFrame = m_slideStart;
+    if (!m_frameTimer->isActive()) {
+        m_frameTimer->start(frameInterval());
+    }
+}
+
+void AnimationManager::onFrame()
+{
+    qint64 now = m_clock.elapsed();
+    FramePacer::instance().recordFrame(now - m_lastFrame, frameInterval());
+    m_lastFrame = now;
+    
+    qreal progress = qBound(0.0, (now - m_slideStart) / qreal(m_slideDuration), 1.0);
+    if (progress >= 1.0) {
+        finishSlide();
+        return;
+    }
+    
+    static const QEasingCurve easing(QEasingCurve::OutCubic);
+    m_snapshot->move(m_slideFrom + (m_slideTo - m_slideFrom) * easing.valueForProgress(progress));
+}
+
+void AnimationManager::finishSlide()
+{
+    m_frameTimer->stop();
+    
+    if (!m_isAnimatingOut) {
+        // Swap the live panel in for the snapshot
+        m_targetWidget->setGeometry(getVisiblePosition());
+        m_targetWidget->setWindowOpacity(1.0);
+        m_targetWidget->show();
+    } else {
+        m_targetWidget->hide();
+    }
+    
+    m_snapshot->hide();
+    m_snapshot->clear(); // Release the pixmap until the next slide
+    
+    emit animationFinished();
+}
+
+int AnimationManager::frameInterval() const
+{
+    QScreen* screen = m_targetWidget ? m_targetWidget->screen() : QApplication::primaryScreen();
+    if (!screen || screen->refreshRate() <= 0) {
+        return FALLBACK_FRAME_INTERVAL;
+    }
+    return qMax(1, qRound(1000.0 / screen->refreshRate()));
+}
+
+void AnimationManager::warmUp()
+{
+    if (!m_targetWidget || m_isVisible || m_targetWidget->isVisible()) return;
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    // The hidden position is just past the screen edge, and the widget is
+    // transparent as well in case the window manager pulls it on screen
+    m_targetWidget->ensurePolished();
+    m_targetWidget->setGeometry(getHiddenPosition());
+    m_targetWidget->setWindowOpacity(0.0);
+    m_targetWidget->show();
+    m_snapshot->create();
+    
+    QTimer::singleShot(0, this, [this]() {
+        if (!m_isVisible && m_targetWidget) {
+            m_targetWidget->hide();
+        }
+        if (m_targetWidget) {
+            m_targetWidget->setWindowOpacity(1.0);
+        }
+    });
+    
+    Logger::debug(QString("Panel warmed up in %1 ms").arg(timer.elapsed()));
 }
 
 void AnimationManager::fadeIn()
@@ -93,6 +204,7 @@ void AnimationManager::fadeIn()
     if (!m_targetWidget) return;
     
     m_targetWidget->show();
+    m_fadeAnimation->setDuration(FramePacer::instance().duration(ANIMATION_DURATION));
     m_fadeAnimation->setStartValue(0.0);
     m_fadeAnimation->setEndValue(1.0);
     m_fadeAnimation->start();
@@ -102,6 +214,7 @@ void AnimationManager::fadeOut()
 {
     if (!m_targetWidget) return;
     
+    m_fadeAnimation->setDuration(FramePacer::instance().duration(ANIMATION_DURATION));
     m_fadeAnimation->setStartValue(1.0);
     m_fadeAnimation->setEndValue(0.0);
     m_fadeAnimation->start();
@@ -157,10 +270,5 @@ QRect AnimationManager::getVisiblePosition()
 
 void AnimationManager::onAnimationFinished()
 {
-    // If we were animating out, hide the widget for optimization
-    if (m_isAnimatingOut && m_targetWidget) {
-        m_targetWidget->hide();
-    }
-    
     emit animationFinished();
 }
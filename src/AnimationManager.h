@@ -4,9 +4,17 @@
 #include <QObject>
 #include <QPropertyAnimation>
 #include <QEasingCurve>
+#include <QElapsedTimer>
+#include <QPoint>
+#include <QTimer>
 
 class QWidget;
+class QLabel;
 
+// Slides the panel in and out. Rather than moving the live panel, a snapshot
+// of it is grabbed once and slid in a separate frameless window, so nothing
+// in the panel is laid out or repainted per frame. Slide durations come from
+// FramePacer and shrink or drop to zero when frames are being missed.
 class AnimationManager : public QObject
 {
     Q_OBJECT
@@ -19,26 +27,44 @@ public:
     void slideOut();
     void fadeIn();
     void fadeOut();
+    
+    // Maps the hidden widget once off-screen so its surface and layout exist
+    // before the first slideIn()
+    void warmUp();
 
 signals:
     void animationFinished();
 
 private slots:
+    void onFrame();
     void onAnimationFinished();
 
 private:
     void setupAnimations();
+    void captureSnapshot();
+    void startSlide(const QPoint& from, const QPoint& to);
+    void finishSlide();
+    int frameInterval() const;
     QRect getHiddenPosition();
     QRect getVisiblePosition();
     
     QWidget* m_targetWidget;
-    QPropertyAnimation* m_slideAnimation;
+    QLabel* m_snapshot;   // Top-level window showing the grabbed panel while it slides
     QPropertyAnimation* m_fadeAnimation;
     
+    QTimer* m_frameTimer;
+    QElapsedTimer m_clock;
+    QPoint m_slideFrom;
+    QPoint m_slideTo;
+    qint64 m_slideStart;
+    qint64 m_lastFrame;
+    int m_slideDuration;
+    
     bool m_isVisible;
     bool m_isAnimatingOut; // Track if we're animating out (for hiding)
     
-    static constexpr int ANIMATION_DURATION = 0;
+    static constexpr int ANIMATION_DURATION = 250;
+    static constexpr int FALLBACK_FRAME_INTERVAL = 16; // ms, when the refresh rate is unknown
 };
 
 #endif // ANIMATIONMANAGER_H
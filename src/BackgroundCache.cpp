@@ -0,0 +1,70 @@
+#include "BackgroundCache.h"
+
+#include <QPainter>
+#include <QPixmap>
+#include <QPixmapCache>
+#include <QMargins>
+#include <qdrawutil.h>
+#include <QtMath>
+
+namespace {
+
+void drawRoundedBackground(QPainter* painter, const QRectF& rect, const BackgroundCache::Style& style)
+{
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setBrush(style.fill);
+    painter->setPen(QPen(style.border, 1));
+    painter->drawRoundedRect(rect.adjusted(style.inset, style.inset, -style.inset, -style.inset),
+                             style.radius, style.radius);
+}
+
+} // namespace
+
+void BackgroundCache::draw(QPainter* painter, const QRect& rect, const Style& style)
+{
+    // Corners plus border and inset stay fixed, a 1px middle row and column stretch
+    int margin = style.radius + style.inset + 1;
+    int side = 2 * margin + 1;
+    
+    if (rect.width() < side || rect.height() < side) {
+        painter->save();
+        drawRoundedBackground(painter, rect, style);
+        painter->restore();
+        return;
+    }
+    
+    qreal dpr = painter->device() ? painter->device()->devicePixelRatio() : 1.0;
+    QString key = QString("relay-bg:%1:%2:%3:%4:%5")
+        .arg(style.fill.rgba()).arg(style.border.rgba())
+        .arg(style.radius).arg(style.inset).arg(dpr);
+    
+    QPixmap pixmap;
+    if (!QPixmapCache::find(key, &pixmap)) {
+        pixmap = QPixmap(qCeil(side * dpr), qCeil(side * dpr));
+        pixmap.setDevicePixelRatio(dpr);
+        pixmap.fill(Qt::transparent);
+        
+        QPainter pixmapPainter(&pixmap);
+        drawRoundedBackground(&pixmapPainter, QRectF(0, 0, side, side), style);
+        pixmapPainter.end();
+        
+        QPixmapCache::insert(key, pixmap);
+    }
+    
+    qDrawBorderPixmap(painter, rect, QMargins(margin, margin, margin, margin), pixmap);
+}
+
+BackgroundCache::Style BackgroundCache::cardStyle(bool hovered)
+{
+    return {
+        hovered ? QColor(60, 60, 60, 200) : QColor(45, 45, 45, 180),
+        QColor(255, 255, 255, hovered ? 40 : 20),
+        8,
+        1
+    };
+}
+
+BackgroundCache::Style BackgroundCache::panelStyle()
+{
+    return {QColor(30, 30, 30, 230), QColor(255, 255, 255, 25), 12, 0};
+}
@@ -0,0 +1,29 @@
+#ifndef BACKGROUNDCACHE_H
+#define BACKGROUNDCACHE_H
+
+#include <QColor>
+#include <QRect>
+
+class QPainter;
+
+// Draws the translucent rounded backgrounds of cards, popups and the panel
+// from cached nine-patch pixmaps instead of antialiasing a rounded rect with
+// alpha on every repaint. Pixmaps are kept per style and device pixel ratio,
+// so one pixmap serves every size.
+class BackgroundCache
+{
+public:
+    struct Style {
+        QColor fill;
+        QColor border;
+        int radius;
+        int inset;  // Distance of the 1px border from the widget edge
+    };
+    
+    static void draw(QPainter* painter, const QRect& rect, const Style& style);
+    
+    static Style cardStyle(bool hovered);
+    static Style panelStyle();
+};
+
+#endif // BACKGROUNDCACHE_H
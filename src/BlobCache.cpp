@@ -0,0 +1,217 @@
+#include "BlobCache.h"
+#include "Logger.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+
+BlobCache* BlobCache::instance()
+{
+    static BlobCache* cache = new BlobCache(QCoreApplication::instance());
+    return cache;
+}
+
+BlobCache::BlobCache(QObject *parent)
+    : QObject(parent)
+    , m_pool(nullptr)
+    , m_diskBytes(0)
+    , m_trimming(false)
+    , m_images(MAX_MEMORY_KB)
+{
+    // One worker keeps decodes and writes from competing with card rendering
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount(1);
+    
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/blobs";
+    QDir().mkpath(m_directory);
+    
+    // Listing names is cheap; sizes and ages are only read when trimming
+    const QStringList names = QDir(m_directory).entryList(QDir::Files);
+    for (const QString& name : names) {
+        if (isValidHash(name)) {
+            m_onDisk.insert(name);
+        }
+    }
+    trimDisk();
+}
+
+BlobCache::~BlobCache()
+{
+    m_pool->clear();
+    m_pool->waitForDone();
+}
+
+bool BlobCache::isValidHash(const QString& hash)
+{
+    if (hash.size() != 64) {
+        return false;
+    }
+    for (const QChar& ch : hash) {
+        if (!((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString BlobCache::pathFor(const QString& hash) const
+{
+    return m_directory + '/' + hash;
+}
+
+void BlobCache::store(const QString& hash, const QByteArray& data)
+{
+    if (!isValidHash(hash) || contains(hash)) {
+        return;
+    }
+    m_storing.insert(hash);
+    
+    // Written under a temporary name so a crash never leaves a truncated blob
+    QString path = pathFor(hash);
+    auto watcher = new QFutureWatcher<bool>(this);
+    qint64 size = data.size();
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, hash, size]() {
+        bool written = watcher->result();
+        watcher->deleteLater();
+        m_storing.remove(hash);
+        if (!written) {
+            Logger::warning(QString("Failed to cache blob %1").arg(hash));
+            return;
+        }
+        m_onDisk.insert(hash);
+        m_diskBytes += size;
+        if (m_diskBytes > MAX_DISK_BYTES) {
+            trimDisk();
+        }
+        emit imageReady(hash);
+    });
+    watcher->setFuture(QtConcurrent::run(m_pool, [path, data]() {
+        QFile file(path + ".part");
+        if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+            file.remove();
+            return false;
+        }
+        file.close();
+        QFile::remove(path);
+        return file.rename(path);
+    }));
+}
+
+QImage BlobCache::image(const QString& hash, const QSize& size, qreal devicePixelRatio)
+{
+    if (hash.isEmpty() || size.isEmpty() || !m_onDisk.contains(hash)) {
+        return QImage();
+    }
+    
+    Key key{hash, size * devicePixelRatio};
+    if (QImage* cached = m_images.object(key)) {
+        return *cached;
+    }
+    if (m_pending.contains(key)) {
+        return QImage();
+    }
+    
+    m_pending.insert(key);
+    auto watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, key]() {
+        QImage image = watcher->result();
+        m_pending.remove(key);
+        watcher->deleteLater();
+        if (image.isNull()) {
+            Logger::warning(QString("Failed to decode blob %1").arg(key.hash));
+            return;
+        }
+        int costKb = qMax<qsizetype>(1, image.sizeInBytes() / 1024);
+        m_images.insert(key, new QImage(image), costKb);
+        emit imageReady(key.hash);
+    });
+    watcher->setFuture(QtConcurrent::run(m_pool, &BlobCache::decode, pathFor(hash), size, devicePixelRatio));
+    
+    return QImage();
+}
+
+QImage BlobCache::decode(const QString& path, const QSize& size, qreal devicePixelRatio)
+{
+    // Recently used blobs are the last to be trimmed from disk
+    QFile file(path);
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        file.close();
+    }
+    
+    // Let the codec scale while decoding where it can (JPEG), rather than
+    // decoding a full-size photo only to shrink it to an icon
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    QSize target = size * devicePixelRatio;
+    QSize original = reader.size();
+    if (original.isValid()) {
+        reader.setScaledSize(original.scaled(target, Qt::KeepAspectRatio));
+    }
+    
+    QImage image = reader.read();
+    if (image.isNull()) {
+        return image;
+    }
+    if (!original.isValid() && (image.width() > target.width() || image.height() > target.height())) {
+        image = image.scaled(target, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    image.setDevicePixelRatio(devicePixelRatio);
+    return image;
+}
+
+void BlobCache::trimDisk()
+{
+    if (m_trimming) {
+        return;
+    }
+    m_trimming = true;
+    
+    // The constructor's pass only learns the size; later passes trim once
+    // stores have pushed the total over the budget
+    QString directory = m_directory;
+    qint64 keepBytes = m_diskBytes > MAX_DISK_BYTES ? TRIM_TARGET_BYTES : MAX_DISK_BYTES;
+    auto watcher = new QFutureWatcher<TrimResult>(this);
+    connect(watcher, &QFutureWatcher<TrimResult>::finished, this, [this, watcher]() {
+        const TrimResult result = watcher->result();
+        watcher->deleteLater();
+        m_trimming = false;
+        for (const QString& hash : result.removed) {
+            m_onDisk.remove(hash);
+        }
+        m_diskBytes = result.keptBytes;
+        if (!result.removed.isEmpty()) {
+            Logger::debug(QString("Trimmed %1 cached blobs").arg(result.removed.size()));
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(m_pool, [directory, keepBytes]() {
+        TrimResult result;
+        result.keptBytes = 0;
+        QFileInfoList files = QDir(directory).entryInfoList(QDir::Files, QDir::Time);
+        
+        // Newest first: keep files until the budget is spent, then drop the rest
+        qint64 total = 0;
+        for (const QFileInfo& info : std::as_const(files)) {
+            if (!isValidHash(info.fileName())) {
+                // Leftover from an interrupted write
+                QFile::remove(info.filePath());
+                continue;
+            }
+            total += info.size();
+            if (total > keepBytes && QFile::remove(info.filePath())) {
+                result.removed.append(info.fileName());
+            } else {
+                result.keptBytes += info.size();
+            }
+        }
+        return result;
+    }));
+}
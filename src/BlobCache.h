@@ -0,0 +1,86 @@
+#ifndef BLOBCACHE_H
+#define BLOBCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QHashFunctions>
+#include <QImage>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+
+class QThreadPool;
+
+// Icons and images sent by the phone, addressed by the SHA-256 of their
+// bytes. Received blobs are kept on disk, so a hash seen once is never
+// transferred again; decoded images scaled to the size they are drawn at
+// are kept in a bounded LRU memory cache. Disk writes and decoding run on a
+// worker thread. GUI thread only.
+class BlobCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static BlobCache* instance();
+
+    // Hashes are 64 lowercase hex digits; anything else is never requested or stored
+    static bool isValidHash(const QString& hash);
+    QString pathFor(const QString& hash) const;
+    
+    // True once the blob is on disk or being written; otherwise it has to be requested
+    bool contains(const QString& hash) const { return m_onDisk.contains(hash) || m_storing.contains(hash); }
+    // Takes a complete, verified blob and writes it to disk
+    void store(const QString& hash, const QByteArray& data);
+    
+    // Returns the blob decoded to fit size (in device-independent pixels),
+    // or a null image after queueing a decode that reports through imageReady()
+    QImage image(const QString& hash, const QSize& size, qreal devicePixelRatio);
+    
+    // Drops every decoded image; blobs on disk are kept
+    void clear() { m_images.clear(); }
+    
+    static constexpr int MAX_MEMORY_KB = 8 * 1024;
+    static constexpr qint64 MAX_DISK_BYTES = 64 * 1024 * 1024;
+    // Trimming goes below the budget so it does not run after every store
+    static constexpr qint64 TRIM_TARGET_BYTES = MAX_DISK_BYTES * 3 / 4;
+
+signals:
+    // The blob arrived or an image decoded from it is ready; draw it again
+    void imageReady(const QString& hash);
+
+private:
+    explicit BlobCache(QObject *parent = nullptr);
+    ~BlobCache();
+    
+    struct Key {
+        QString hash;
+        QSize size;  // In device pixels
+        
+        bool operator==(const Key& other) const {
+            return size == other.size && hash == other.hash;
+        }
+        friend size_t qHash(const Key& key, size_t seed = 0) {
+            return qHashMulti(seed, key.hash, key.size.width(), key.size.height());
+        }
+    };
+    
+    struct TrimResult {
+        QStringList removed;
+        qint64 keptBytes;
+    };
+    
+    void trimDisk();
+    static QImage decode(const QString& path, const QSize& size, qreal devicePixelRatio);
+    
+    QString m_directory;
+    QThreadPool* m_pool;
+    QSet<QString> m_onDisk;
+    QSet<QString> m_storing;  // Queued or being written
+    qint64 m_diskBytes;       // Of m_onDisk, as of the last trim plus later stores
+    bool m_trimming;
+    QCache<Key, QImage> m_images;
+    QSet<Key> m_pending;
+};
+
+#endif // BLOBCACHE_H
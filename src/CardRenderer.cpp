@@ -0,0 +1,165 @@
+#include "CardRenderer.h"
+#include "TextLayoutCache.h"
+
+#include <QFontMetrics>
+#include <QFutureWatcher>
+#include <QHashFunctions>
+#include <QPainter>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+CardRenderer::CardRenderer(QObject *parent)
+    : QObject(parent)
+    , m_pool(nullptr)
+    , m_images(MAX_CACHE_KB)
+{
+    // A private pool keeps card rendering from starving history reads
+    m_pool = new QThreadPool(this);
+    m_pool->setMaxThreadCount(WORKER_THREADS);
+}
+
+CardRenderer::~CardRenderer()
+{
+    m_pool->clear();
+    m_pool->waitForDone();
+}
+
+CardRenderer::Key CardRenderer::keyFor(const Content& content)
+{
+    size_t revision = qHashMulti(0, content.appName, content.title, content.body, content.indicator);
+    revision = qHashMulti(revision, content.hasIcon, content.hasImage, content.icon.cacheKey(), content.image.cacheKey());
+    revision = qHashMulti(revision, content.appFont.key(), content.titleFont.key(), content.bodyFont.key());
+    return Key{content.id, revision, content.size, content.devicePixelRatio};
+}
+
+QImage CardRenderer::image(const Content& content, const QPersistentModelIndex& index)
+{
+    if (content.size.isEmpty()) {
+        return QImage();
+    }
+    
+    Key key = keyFor(content);
+    if (QImage* cached = m_images.object(key)) {
+        return *cached;
+    }
+    if (m_pending.contains(key)) {
+        return QImage();
+    }
+    
+    m_pending.insert(key);
+    auto watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, key, index]() {
+        QImage image = watcher->result();
+        m_pending.remove(key);
+        int costKb = qMax<qsizetype>(1, image.sizeInBytes() / 1024);
+        m_images.insert(key, new QImage(image), costKb);
+        watcher->deleteLater();
+        if (index.isValid()) {
+            emit imageReady(index);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(m_pool, &CardRenderer::render, content));
+    
+    return QImage();
+}
+
+QRect CardRenderer::fitted(const QImage& image, const QRect& bounds)
+{
+    // Pictures are decoded to fit the box; centre them in it
+    QSize size = image.deviceIndependentSize().toSize().scaled(bounds.size(), Qt::KeepAspectRatio);
+    QRect rect(QPoint(0, 0), size);
+    rect.moveCenter(bounds.center());
+    return rect;
+}
+
+QImage CardRenderer::render(const Content& content)
+{
+    QSize pixelSize = content.size * content.devicePixelRatio;
+    QImage image(pixelSize, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(content.devicePixelRatio);
+    image.fill(Qt::transparent);
+    
+    QPainter painter(&image);
+    paintStatic(&painter, content);
+    painter.end();
+    
+    return image;
+}
+
+void CardRenderer::paintContent(QPainter* painter, const Content& content)
+{
+    paintStatic(painter, content);
+    paintTime(painter, content);
+}
+
+void CardRenderer::paintTime(QPainter* painter, const Content& content)
+{
+    // Right-aligned before the remove glyph
+    QRect header(0, 0, content.size.width(), HEADER_HEIGHT);
+    painter->setRenderHint(QPainter::TextAntialiasing);
+    painter->setFont(content.timeFont);
+    painter->setPen(QColor(255, 255, 255, 128));
+    painter->drawText(header.adjusted(0, 0, -(HEADER_HEIGHT + HEADER_SPACING), 0),
+                      Qt::AlignRight | Qt::AlignVCenter, content.time);
+}
+
+void CardRenderer::paintStatic(QPainter* painter, const Content& content)
+{
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setRenderHint(QPainter::TextAntialiasing);
+    
+    int width = content.size.width();
+    QRect header(0, 0, width, HEADER_HEIGHT);
+    
+    // Header: icon, app name and expand indicator on the left, remove glyph on the right
+    int x = 0;
+    if (content.hasIcon) {
+        if (!content.icon.isNull()) {
+            painter->drawImage(fitted(content.icon, QRect(0, (HEADER_HEIGHT - ICON_SIZE) / 2, ICON_SIZE, ICON_SIZE)),
+                               content.icon);
+        }
+        x = ICON_SIZE + CONTENT_SPACING;
+    }
+    
+    QFontMetrics appMetrics(content.appFont);
+    QString appName = appMetrics.elidedText(content.appName, Qt::ElideRight, width / 2 - x);
+    painter->setFont(content.appFont);
+    painter->setPen(QColor(255, 255, 255, 204));
+    painter->drawText(header.adjusted(x, 0, 0, 0), Qt::AlignLeft | Qt::AlignVCenter, appName);
+    
+    if (content.indicator) {
+        x += appMetrics.horizontalAdvance(appName) + HEADER_SPACING;
+        painter->setFont(content.indicatorFont);
+        painter->setPen(QColor(255, 255, 255, 153));
+        painter->drawText(QRect(x, 0, HEADER_HEIGHT, HEADER_HEIGHT), Qt::AlignCenter, "⌄");
+    }
+    
+    QRect removeRect(width - HEADER_HEIGHT, 0, HEADER_HEIGHT, HEADER_HEIGHT);
+    painter->setFont(content.removeFont);
+    painter->setPen(QColor(255, 255, 255, 153));
+    painter->drawText(removeRect, Qt::AlignCenter, "×");
+    
+    // Content: wrapped title and latest body, beside the picture if there is one
+    int y = HEADER_HEIGHT + HEADER_SPACING;
+    if (content.hasImage && !content.image.isNull()) {
+        painter->drawImage(fitted(content.image, QRect(width - IMAGE_SIZE, y, IMAGE_SIZE, IMAGE_SIZE)),
+                           content.image);
+    }
+    width = textWidth(width, content.hasImage);
+    
+    // Measured exactly as the delegate's sizeHint() measures the row
+    if (!content.title.isEmpty()) {
+        int titleHeight = TextLayoutCache::wrappedRect(content.title, content.titleFont, width).height();
+        painter->setFont(content.titleFont);
+        painter->setPen(Qt::white);
+        painter->drawText(QRect(0, y, width, titleHeight), TextLayoutCache::WRAP_FLAGS, content.title);
+        y += titleHeight + CONTENT_SPACING;
+    }
+    
+    if (!content.body.isEmpty()) {
+        int bodyHeight = TextLayoutCache::wrappedRect(content.body, content.bodyFont, width).height();
+        painter->setFont(content.bodyFont);
+        painter->setPen(QColor(255, 255, 255, 204));
+        painter->drawText(QRect(0, y, width, bodyHeight), TextLayoutCache::WRAP_FLAGS, content.body);
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef CARDRENDERER_H
+#define CARDRENDERER_H
+
+#include <QObject>
+#include <QCache>
+#include <QFont>
+#include <QHashFunctions>
+#include <QImage>
+#include <QPersistentModelIndex>
+#include <QSet>
+#include <QSize>
+
+class QPainter;
+class QThreadPool;
+
+// Rasterizes the text content of notification cards (header, title and body)
+// into QImages on a small worker pool, so painting a row on the GUI thread
+// is a single blit. Images are keyed by notification ID, a revision hashed
+// from the content and fonts, size and device pixel ratio, so any change of
+// text or width simply misses the cache. The relative time changes every
+// minute and is drawn over the image instead of being part of it. Workers
+// only paint on QImages, which Qt 6 supports outside the GUI thread.
+class CardRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Content {
+        int id;          // Notification ID, the first part of the cache key
+        QString appName;
+        QString time;
+        QString title;
+        QString body;
+        bool indicator;  // Expand arrow for grouped notifications or actions
+        // Space is kept for the pictures while they are still loading, so
+        // the layout does not shift when they arrive
+        bool hasIcon;    // App or contact icon before the app name
+        bool hasImage;   // Picture to the right of the title and body
+        QImage icon;
+        QImage image;
+        QFont appFont;
+        QFont indicatorFont;
+        QFont removeFont;
+        QFont timeFont;
+        QFont titleFont;
+        QFont bodyFont;
+        QSize size;      // Content rect, excluding the card margins
+        qreal devicePixelRatio;
+    };
+    
+    explicit CardRenderer(QObject *parent = nullptr);
+    ~CardRenderer();
+
+    // Returns the rendered content, or a null image after queueing a render
+    // that reports back through imageReady()
+    QImage image(const Content& content, const QPersistentModelIndex& index);
+    
+    // Drops every cached image; renders in flight still land in the cache
+    void clear() { m_images.clear(); }
+    
+    // Paints the content at the painter's origin; thread-safe for QImage painters
+    static void paintContent(QPainter* painter, const Content& content);
+    // Paints only the time, over an image from image()
+    static void paintTime(QPainter* painter, const Content& content);
+    
+    static constexpr int MAX_CACHE_KB = 32 * 1024;
+    static constexpr int WORKER_THREADS = 2;
+    static constexpr int HEADER_HEIGHT = 20;
+    static constexpr int HEADER_SPACING = 8;
+    static constexpr int CONTENT_SPACING = 4;
+    static constexpr int ICON_SIZE = 16;
+    static constexpr int IMAGE_SIZE = 48;
+    
+    // Width left for the title and body beside the picture, if any
+    static int textWidth(int width, bool hasImage) { return hasImage ? width - IMAGE_SIZE - HEADER_SPACING : width; }
+
+signals:
+    void imageReady(const QPersistentModelIndex& index);
+
+private:
+    struct Key {
+        int id;
+        size_t revision;  // Hash of everything drawn except the time
+        QSize size;
+        qreal devicePixelRatio;
+        
+        bool operator==(const Key& other) const {
+            return id == other.id && revision == other.revision && size == other.size
+                && qFuzzyCompare(devicePixelRatio, other.devicePixelRatio);
+        }
+        friend size_t qHash(const Key& key, size_t seed = 0) {
+            return qHashMulti(seed, key.id, key.revision, key.size.width(), key.size.height(),
+                              qRound(key.devicePixelRatio * 100));
+        }
+    };
+    
+    static Key keyFor(const Content& content);
+    static QImage render(const Content& content);
+    // Everything but the time, which paintTime() draws
+    static void paintStatic(QPainter* painter, const Content& content);
+    static QRect fitted(const QImage& image, const QRect& bounds);
+    
+    QThreadPool* m_pool;
+    QCache<Key, QImage> m_images;
+    QSet<Key> m_pending;
+};
+
+#endif // CARDRENDERER_H
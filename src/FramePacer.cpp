@@ -0,0 +1,66 @@
+#include "FramePacer.h"
+#include "Logger.h"
+
+FramePacer& FramePacer::instance()
+{
+    static FramePacer pacer;
+    return pacer;
+}
+
+FramePacer::FramePacer()
+    : m_averageRatio(1.0)
+    , m_reported(Quality::Full)
+{
+}
+
+void FramePacer::recordFrame(qint64 intervalMs, int expectedMs)
+{
+    if (expectedMs <= 0 || intervalMs < 0) {
+        return;
+    }
+    
+    // Skipped animations record no frames, so a stale average is forgotten
+    // rather than keeping animations off forever
+    if (!m_sinceLastFrame.isValid() || m_sinceLastFrame.elapsed() > RECOVERY_MS) {
+        m_averageRatio = 1.0;
+    }
+    m_sinceLastFrame.start();
+    
+    qreal ratio = qreal(intervalMs) / expectedMs;
+    m_averageRatio += SMOOTHING * (ratio - m_averageRatio);
+    
+    Quality current = quality();
+    if (current != m_reported) {
+        static const char* names[] = {"full", "reduced", "off"};
+        Logger::info(QString("Animation quality %1 (frames at %2x the display interval)")
+                     .arg(names[static_cast<int>(current)]).arg(m_averageRatio, 0, 'f', 1));
+        m_reported = current;
+    }
+}
+
+FramePacer::Quality FramePacer::quality() const
+{
+    if (!m_sinceLastFrame.isValid() || m_sinceLastFrame.elapsed() > RECOVERY_MS) {
+        return Quality::Full;
+    }
+    if (m_averageRatio >= OFF_RATIO) {
+        return Quality::Off;
+    }
+    if (m_averageRatio >= REDUCED_RATIO) {
+        return Quality::Reduced;
+    }
+    return Quality::Full;
+}
+
+int FramePacer::duration(int durationMs) const
+{
+    switch (quality()) {
+    case Quality::Full:
+        return durationMs;
+    case Quality::Reduced:
+        return durationMs / 2;
+    case Quality::Off:
+        return 0;
+    }
+    return durationMs;
+}
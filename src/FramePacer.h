@@ -0,0 +1,42 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+// Tracks how well animation frames keep up with the display and scales
+// animation durations to match: full length when frames arrive on time,
+// halved when frames are being dropped, and skipped entirely under heavy
+// load. Animations report each frame through recordFrame(). GUI thread only.
+class FramePacer
+{
+public:
+    enum class Quality {
+        Full,
+        Reduced,
+        Off
+    };
+    
+    static FramePacer& instance();
+
+    // intervalMs is the time since the animation's previous frame
+    void recordFrame(qint64 intervalMs, int expectedMs);
+    
+    // Duration to use for an animation that nominally lasts durationMs; 0 means jump to the end
+    int duration(int durationMs) const;
+    Quality quality() const;
+    
+    static constexpr qreal SMOOTHING = 0.2;        // Weight of the newest frame in the average
+    static constexpr qreal REDUCED_RATIO = 1.5;    // Average interval over expected that halves durations
+    static constexpr qreal OFF_RATIO = 3.0;        // ...and that skips animations
+    static constexpr int RECOVERY_MS = 2000;       // Without frames for this long, assume load has passed
+
+private:
+    FramePacer();
+    
+    qreal m_averageRatio;
+    Quality m_reported;
+    QElapsedTimer m_sinceLastFrame;
+};
+
+#endif // FRAMEPACER_H
@@ -0,0 +1,57 @@
+#include "GroupBodiesModel.h"
+
+GroupBodiesModel::GroupBodiesModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+GroupBodiesModel::~GroupBodiesModel()
+{
+}
+
+int GroupBodiesModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_bodies.size();
+}
+
+QVariant GroupBodiesModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_bodies.size() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    
+    // Row 0 is the newest body, the last entry of the ring
+    return m_bodies[m_bodies.size() - 1 - index.row()];
+}
+
+void GroupBodiesModel::setBodies(const QStringList& bodies)
+{
+    // The ring only grows at its end and evicts from its front, and bodies are
+    // unique, so the old newest body locates the appended ones and the new
+    // oldest body the evicted ones
+    qsizetype keptFrom = bodies.isEmpty() ? -1 : m_bodies.indexOf(bodies.first());
+    qsizetype keptTo = m_bodies.isEmpty() ? -1 : bodies.indexOf(m_bodies.last());
+    
+    if (m_bodies.isEmpty() || keptFrom < 0 || keptTo < 0
+        || m_bodies.size() - keptFrom != keptTo + 1) {
+        beginResetModel();
+        m_bodies = bodies;
+        endResetModel();
+        return;
+    }
+    
+    // Evicted oldest bodies are the bottom rows
+    if (keptFrom > 0) {
+        beginRemoveRows(QModelIndex(), m_bodies.size() - keptFrom, m_bodies.size() - 1);
+        m_bodies.remove(0, keptFrom);
+        endRemoveRows();
+    }
+    
+    // Appended bodies become the top rows
+    qsizetype appended = bodies.size() - 1 - keptTo;
+    if (appended > 0) {
+        beginInsertRows(QModelIndex(), 0, appended - 1);
+        m_bodies.append(bodies.mid(keptTo + 1));
+        endInsertRows();
+    }
+}
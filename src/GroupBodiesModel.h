@@ -0,0 +1,28 @@
+#ifndef GROUPBODIESMODEL_H
+#define GROUPBODIESMODEL_H
+
+#include <QAbstractListModel>
+#include <QStringList>
+
+// The bodies of an expanded notification group, newest first, for a
+// virtualized list. setBodies() takes the group's ring of bodies (oldest
+// first) and applies the difference to the previous ring as row inserts at
+// the top and removals at the bottom, so a new message never resets the list.
+class GroupBodiesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit GroupBodiesModel(QObject *parent = nullptr);
+    ~GroupBodiesModel();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    
+    void setBodies(const QStringList& bodies);
+
+private:
+    QStringList m_bodies;  // Oldest first, as in NotificationData::bodies
+};
+
+#endif // GROUPBODIESMODEL_H
@@ -0,0 +1,899 @@
+#include "HistoryStore.h"
+#include "Logger.h"
+
+#include <QCborMap>
+#include <QCborValue>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+#include <QtEndian>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace {
+
+// Log record: magic, payload length, timestamp (ms), CBOR payload
+constexpr quint32 RECORD_MAGIC = 0x314C4852; // "RHL1"
+constexpr qint64 RECORD_HEADER_SIZE = 16;
+
+// Index: magic, version, first sequence number, then one entry per record
+constexpr quint32 INDEX_MAGIC = 0x31584952;  // "RIX1"
+constexpr quint32 INDEX_VERSION = 1;
+constexpr qint64 INDEX_HEADER_SIZE = 16;
+constexpr qint64 INDEX_ENTRY_SIZE = 16;      // offset, timestamp (ms)
+
+// Tombstone file: one framed CBOR map per removal, magic and payload length first
+constexpr quint32 TOMBSTONE_MAGIC = 0x31544852; // "RHT1"
+constexpr qint64 TOMBSTONE_HEADER_SIZE = 8;
+
+constexpr qint64 COPY_CHUNK_SIZE = 1024 * 1024;
+
+bool syncFile(QFile& file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#if defined(Q_OS_UNIX)
+    return ::fsync(file.handle()) == 0;
+#elif defined(Q_OS_WIN)
+    return ::_commit(file.handle()) == 0;
+#else
+    return true;
+#endif
+}
+
+// Atomically replaces to with from, unlike QFile::rename(), which refuses
+// to overwrite. The rename is made durable before returning.
+bool replaceFile(const QString& from, const QString& to)
+{
+#if defined(Q_OS_UNIX)
+    if (::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) != 0) {
+        return false;
+    }
+    int dir = ::open(QFile::encodeName(QFileInfo(to).absolutePath()).constData(), O_RDONLY);
+    if (dir >= 0) {
+        ::fsync(dir);
+        ::close(dir);
+    }
+    return true;
+#elif defined(Q_OS_WIN)
+    return ::MoveFileExW(reinterpret_cast<const wchar_t*>(from.utf16()), reinterpret_cast<const wchar_t*>(to.utf16()),
+                         MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    QFile::remove(to);
+    return QFile::rename(from, to);
+#endif
+}
+
+QByteArray indexHeader(qint64 firstSeq)
+{
+    QByteArray header(INDEX_HEADER_SIZE, 0);
+    qToLittleEndian<quint32>(INDEX_MAGIC, header.data());
+    qToLittleEndian<quint32>(INDEX_VERSION, header.data() + 4);
+    qToLittleEndian<qint64>(firstSeq, header.data() + 8);
+    return header;
+}
+
+QByteArray indexEntry(qint64 offset, qint64 timestampMs)
+{
+    QByteArray entry(INDEX_ENTRY_SIZE, 0);
+    qToLittleEndian<qint64>(offset, entry.data());
+    qToLittleEndian<qint64>(timestampMs, entry.data() + 8);
+    return entry;
+}
+
+QByteArray recordHeader(qint64 payloadSize, qint64 timestampMs)
+{
+    QByteArray header(RECORD_HEADER_SIZE, 0);
+    qToLittleEndian<quint32>(RECORD_MAGIC, header.data());
+    qToLittleEndian<quint32>(static_cast<quint32>(payloadSize), header.data() + 4);
+    qToLittleEndian<qint64>(timestampMs, header.data() + 8);
+    return header;
+}
+
+QByteArray tombstoneFrame(const QCborMap& tombstone)
+{
+    const QByteArray payload = tombstone.toCborValue().toCbor();
+    QByteArray frame(TOMBSTONE_HEADER_SIZE, 0);
+    qToLittleEndian<quint32>(TOMBSTONE_MAGIC, frame.data());
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), frame.data() + 4);
+    return frame + payload;
+}
+
+} // namespace
+
+// Background thread that owns the write handles. Appends are batched and
+// synced once per batch so the GUI thread never waits on fsync.
+class HistoryWriter : public QThread
+{
+public:
+    explicit HistoryWriter(HistoryStore* store)
+        : m_store(store), m_stopping(false), m_compactRequested(false), m_open(false) {}
+
+    void enqueue(const QByteArray& payload, qint64 timestampMs)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_queue.append({payload, timestampMs});
+        m_condition.wakeOne();
+    }
+
+    void enqueueTombstone(const QByteArray& frame)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_tombstoneQueue.append(frame);
+        m_condition.wakeOne();
+    }
+
+    void requestCompaction()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_compactRequested = true;
+        m_condition.wakeOne();
+    }
+
+    void stop()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_condition.wakeOne();
+    }
+
+protected:
+    void run() override;
+
+private:
+    struct PendingRecord {
+        QByteArray payload;
+        qint64 timestampMs;
+    };
+
+    bool openFiles();
+    void reopenFiles();
+    void writeBatch(const QList<PendingRecord>& batch);
+    void writeTombstones();
+    void compactTombstones(qint64 firstSeq);
+    void compact();
+
+    HistoryStore* m_store;
+    QMutex m_mutex;
+    QWaitCondition m_condition;
+    QList<PendingRecord> m_queue;
+    QList<QByteArray> m_tombstoneQueue;
+    bool m_stopping;
+    bool m_compactRequested;
+
+    QFile m_log;
+    QFile m_index;
+    QFile m_tombstones;
+    bool m_open;
+    QByteArray m_unwrittenTombstones;  // Framed, retried with the next wake-up
+    
+    // Index entries not yet written, oldest first. Each one stands for a
+    // sequence number already handed out by append(), so they are kept
+    // until the index accepts them.
+    QByteArray m_unindexed;
+};
+
+bool HistoryWriter::openFiles()
+{
+    if (!m_store->finishCompaction()) {
+        return false;
+    }
+    
+    m_log.setFileName(m_store->m_logPath);
+    m_index.setFileName(m_store->m_indexPath);
+
+    if (!m_log.open(QIODevice::ReadWrite) || !m_index.open(QIODevice::ReadWrite)) {
+        Logger::warning(QString("Failed to open notification history for writing: %1")
+                        .arg(m_log.errorString()));
+        m_log.close();
+        m_index.close();
+        return false;
+    }
+
+    m_log.seek(m_log.size());
+    m_index.seek(m_index.size());
+    
+    // Removals are still applied in memory if their file is unavailable
+    m_tombstones.setFileName(m_store->m_tombstonePath);
+    if (m_tombstones.open(QIODevice::ReadWrite)) {
+        m_tombstones.seek(m_tombstones.size());
+    } else {
+        Logger::warning(QString("Failed to open history tombstones for writing: %1")
+                        .arg(m_tombstones.errorString()));
+    }
+    return true;
+}
+
+void HistoryWriter::reopenFiles()
+{
+    m_log.close();
+    m_index.close();
+    m_tombstones.close();
+    m_open = openFiles();
+}
+
+void HistoryWriter::run()
+{
+    m_open = openFiles();
+
+    forever {
+        QList<PendingRecord> batch;
+        QList<QByteArray> tombstones;
+        bool compactNow = false;
+        bool stopping = false;
+
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_queue.isEmpty() && m_tombstoneQueue.isEmpty() && !m_compactRequested && !m_stopping) {
+                m_condition.wait(&m_mutex);
+            }
+            batch.swap(m_queue);
+            tombstones.swap(m_tombstoneQueue);
+            compactNow = m_compactRequested;
+            m_compactRequested = false;
+            stopping = m_stopping;
+        }
+
+        // Files that failed to open, or were lost in a failed write, are
+        // retried with every batch
+        if (!m_open) {
+            reopenFiles();
+        }
+        if (!batch.isEmpty() || !m_unindexed.isEmpty()) {
+            writeBatch(batch);
+        }
+        for (const QByteArray& frame : std::as_const(tombstones)) {
+            m_unwrittenTombstones.append(frame);
+        }
+        if (!m_unwrittenTombstones.isEmpty()) {
+            writeTombstones();
+        }
+        if (m_open && compactNow) {
+            compact();
+        }
+        if (stopping) {
+            break;
+        }
+    }
+
+    m_log.close();
+    m_index.close();
+    m_tombstones.close();
+}
+
+void HistoryWriter::writeBatch(const QList<PendingRecord>& batch)
+{
+    // Every record gets an index entry, so index positions stay aligned with
+    // the sequence numbers append() handed out. A record that could not be
+    // written gets offset -1, which read() skips.
+    bool failed = !m_open;
+    m_unindexed.reserve(m_unindexed.size() + batch.size() * INDEX_ENTRY_SIZE);
+    for (const PendingRecord& record : batch) {
+        qint64 offset = -1;
+        if (!failed) {
+            offset = m_log.pos();
+            const QByteArray header = recordHeader(record.payload.size(), record.timestampMs);
+            if (m_log.write(header) != header.size() || m_log.write(record.payload) != record.payload.size()) {
+                // Cut off the partial record so nothing is left to misread
+                m_log.resize(offset);
+                failed = true;
+                offset = -1;
+            }
+        }
+        m_unindexed.append(indexEntry(offset, record.timestampMs));
+    }
+
+    // Records must be durable before the index points at them
+    if (!failed && !syncFile(m_log)) {
+        failed = true;
+    }
+    
+    if (!failed) {
+        qint64 indexEnd = m_index.pos();
+        if (m_index.write(m_unindexed) == m_unindexed.size() && syncFile(m_index)) {
+            m_store->m_committedSeq.fetchAndAddOrdered(m_unindexed.size() / INDEX_ENTRY_SIZE);
+            m_unindexed.clear();
+        } else {
+            m_index.resize(indexEnd);
+            failed = true;
+        }
+    }
+
+    if (failed) {
+        Logger::warning(QString("Failed to write notification history (%1); %2 records are waiting")
+                        .arg(m_log.error() != QFileDevice::NoError ? m_log.errorString() : m_index.errorString())
+                        .arg(m_unindexed.size() / INDEX_ENTRY_SIZE));
+        reopenFiles();
+    }
+}
+
+void HistoryWriter::writeTombstones()
+{
+    // A tombstone file that failed to open is retried with every write
+    if (!m_tombstones.isOpen()) {
+        m_tombstones.setFileName(m_store->m_tombstonePath);
+        if (!m_tombstones.open(QIODevice::ReadWrite)) {
+            return;
+        }
+        m_tombstones.seek(m_tombstones.size());
+    }
+
+    qint64 end = m_tombstones.pos();
+    if (m_tombstones.write(m_unwrittenTombstones) == m_unwrittenTombstones.size() && syncFile(m_tombstones)) {
+        m_unwrittenTombstones.clear();
+        return;
+    }
+
+    Logger::warning(QString("Failed to write history tombstones: %1").arg(m_tombstones.errorString()));
+    m_tombstones.resize(end);
+}
+
+void HistoryWriter::compactTombstones(qint64 firstSeq)
+{
+    // Rewritten from the store's pruned set, which already includes any
+    // tombstones still waiting to be written
+    const QList<QCborMap> kept = m_store->pruneTombstones(firstSeq);
+    QByteArray frames;
+    for (const QCborMap& tombstone : kept) {
+        frames.append(tombstoneFrame(tombstone));
+    }
+
+    QFile newTombstones(m_store->m_tombstonePath + ".tmp");
+    if (!newTombstones.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || newTombstones.write(frames) != frames.size() || !syncFile(newTombstones)) {
+        Logger::warning(QString("Failed to compact history tombstones: %1").arg(newTombstones.errorString()));
+        newTombstones.close();
+        newTombstones.remove();
+        return;
+    }
+    newTombstones.close();
+
+    m_tombstones.close();
+    if (replaceFile(newTombstones.fileName(), m_store->m_tombstonePath)) {
+        m_unwrittenTombstones.clear();
+    } else {
+        Logger::warning("Failed to replace history tombstones after compaction");
+        QFile::remove(newTombstones.fileName());
+    }
+    
+    m_tombstones.setFileName(m_store->m_tombstonePath);
+    if (m_tombstones.open(QIODevice::ReadWrite)) {
+        m_tombstones.seek(m_tombstones.size());
+    }
+}
+
+void HistoryWriter::compact()
+{
+    // Pending index entries hold offsets into the current log, which
+    // compaction would shift; wait until they are written
+    if (!m_unindexed.isEmpty()) {
+        Logger::debug("Deferred notification history compaction until pending records are indexed");
+        return;
+    }
+    
+    const qint64 firstSeq = m_store->m_firstSeq.loadAcquire();
+    const qint64 count = m_store->m_committedSeq.loadAcquire() - firstSeq;
+    if (count <= 0) {
+        return;
+    }
+
+    // Index entries are fixed-size, so the timestamps can be binary searched
+    // for the first record that is still within the age limit
+    uchar* index = m_index.map(0, m_index.size());
+    if (!index) {
+        return;
+    }
+    auto timestampAt = [index](qint64 pos) {
+        return qFromLittleEndian<qint64>(index + INDEX_HEADER_SIZE + pos * INDEX_ENTRY_SIZE + 8);
+    };
+    auto offsetAt = [index](qint64 pos) {
+        return qFromLittleEndian<qint64>(index + INDEX_HEADER_SIZE + pos * INDEX_ENTRY_SIZE);
+    };
+
+    const qint64 cutoff = QDateTime::currentDateTime().addDays(-HistoryStore::MAX_AGE_DAYS).toMSecsSinceEpoch();
+    qint64 low = 0;
+    qint64 high = count;
+    while (low < high) {
+        qint64 mid = (low + high) / 2;
+        if (timestampAt(mid) < cutoff) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    const qint64 drop = qMax(low, count - HistoryStore::MAX_RECORDS);
+    if (drop <= 0) {
+        m_index.unmap(index);
+        return;
+    }
+
+    // Rewrite the retained tail of the log and a rebased index next to the
+    // originals, then swap them in while readers are locked out. Records
+    // that failed to write have offset -1 and stay holes.
+    qint64 baseOffset = m_log.size();
+    for (qint64 pos = drop; pos < count; ++pos) {
+        if (offsetAt(pos) >= 0) {
+            baseOffset = offsetAt(pos);
+            break;
+        }
+    }
+    // The index copy is created first, so a log copy on its own always
+    // means the index has been replaced (see HistoryStore::finishCompaction())
+    QFile newLog(m_store->m_logPath + ".tmp");
+    QFile newIndex(m_store->m_indexPath + ".tmp");
+    if (!newIndex.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || !newLog.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        Logger::warning("Failed to create files for notification history compaction");
+        m_index.unmap(index);
+        return;
+    }
+
+    bool written = m_log.seek(baseOffset);
+    while (written && !m_log.atEnd()) {
+        const QByteArray chunk = m_log.read(COPY_CHUNK_SIZE);
+        written = !chunk.isEmpty() && newLog.write(chunk) == chunk.size();
+    }
+
+    QByteArray entries = indexHeader(firstSeq + drop);
+    entries.reserve(INDEX_HEADER_SIZE + (count - drop) * INDEX_ENTRY_SIZE);
+    for (qint64 pos = drop; pos < count; ++pos) {
+        qint64 offset = offsetAt(pos);
+        entries.append(indexEntry(offset >= 0 ? offset - baseOffset : -1, timestampAt(pos)));
+    }
+    written = written && newIndex.write(entries) == entries.size();
+    m_index.unmap(index);
+
+    written = written && syncFile(newLog) && syncFile(newIndex);
+    newLog.close();
+    newIndex.close();
+    m_log.seek(m_log.size());
+    
+    // The originals stay in place if the copies are incomplete
+    if (!written) {
+        Logger::warning(QString("Failed to write compacted notification history: %1")
+                        .arg(newLog.error() != QFileDevice::NoError ? newLog.errorString() : newIndex.errorString()));
+        QFile::remove(newLog.fileName());
+        QFile::remove(newIndex.fileName());
+        return;
+    }
+
+    {
+        QWriteLocker locker(&m_store->m_lock);
+        m_log.close();
+        m_index.close();
+
+        // Replacing the index commits the compaction; openFiles() then
+        // replaces the log, and retries that if it fails
+        if (!replaceFile(newIndex.fileName(), m_store->m_indexPath)) {
+            Logger::warning("Failed to replace the notification history index, compaction abandoned");
+            QFile::remove(newLog.fileName());
+            QFile::remove(newIndex.fileName());
+            m_open = openFiles();
+            return;
+        }
+
+        m_store->m_firstSeq.storeRelease(firstSeq + drop);
+        m_open = openFiles();
+    }
+
+    compactTombstones(firstSeq + drop);
+    emit m_store->compacted(firstSeq + drop);
+
+    Logger::debug(QString("Compacted notification history: dropped %1 of %2 records").arg(drop).arg(count));
+}
+
+HistoryStore::HistoryStore(QObject *parent)
+    : QObject(parent)
+    , m_firstSeq(0)
+    , m_committedSeq(0)
+    , m_nextSeq(0)
+    , m_clearedBefore(0)
+    , m_writer(nullptr)
+    , m_compactionTimer(nullptr)
+{
+    m_compactionTimer = new QTimer(this);
+    m_compactionTimer->setInterval(COMPACTION_INTERVAL);
+    connect(m_compactionTimer, &QTimer::timeout, this, &HistoryStore::requestCompaction);
+}
+
+HistoryStore::~HistoryStore()
+{
+    close();
+}
+
+bool HistoryStore::open(const QString& directory)
+{
+    if (isOpen()) {
+        return true;
+    }
+
+    QString dirPath = directory.isEmpty()
+        ? QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+        : directory;
+    if (!QDir().mkpath(dirPath)) {
+        Logger::warning(QString("Cannot create history directory: %1").arg(dirPath));
+        return false;
+    }
+
+    QDir dir(dirPath);
+    m_logPath = dir.filePath("history.log");
+    m_indexPath = dir.filePath("history.idx");
+    m_tombstonePath = dir.filePath("history.tomb");
+
+    if (!recover()) {
+        return false;
+    }
+    m_nextSeq = m_committedSeq.loadAcquire();
+    loadTombstones();
+
+    m_writer = new HistoryWriter(this);
+    m_writer->start(QThread::LowPriority);
+
+    m_compactionTimer->start();
+    QTimer::singleShot(30 * 1000, this, &HistoryStore::requestCompaction);
+
+    Logger::debug(QString("Opened notification history with %1 records")
+                  .arg(m_committedSeq.loadAcquire() - m_firstSeq.loadAcquire()));
+    return true;
+}
+
+void HistoryStore::close()
+{
+    m_compactionTimer->stop();
+
+    if (m_writer) {
+        // The writer drains its queue before exiting
+        m_writer->stop();
+        m_writer->wait();
+        delete m_writer;
+        m_writer = nullptr;
+    }
+}
+
+bool HistoryStore::finishCompaction()
+{
+    // compact() writes the index copy, then the log copy, then commits by
+    // replacing the index and finally replaces the log. A log copy without
+    // an index copy means it stopped between the two replacements.
+    const QString newLog = m_logPath + ".tmp";
+    const QString newIndex = m_indexPath + ".tmp";
+    if (!QFile::exists(newLog)) {
+        QFile::remove(newIndex);
+        return true;
+    }
+    if (QFile::exists(newIndex)) {
+        // Stopped before the commit; the originals are intact
+        QFile::remove(newLog);
+        QFile::remove(newIndex);
+        return true;
+    }
+    if (!replaceFile(newLog, m_logPath)) {
+        Logger::warning("Cannot finish notification history compaction: failed to replace the log");
+        return false;
+    }
+    return true;
+}
+
+bool HistoryStore::recover()
+{
+    if (!finishCompaction()) {
+        return false;
+    }
+    
+    QFile index(m_indexPath);
+    if (!index.exists() || index.size() < INDEX_HEADER_SIZE) {
+        return rebuildIndex();
+    }
+    if (!index.open(QIODevice::ReadWrite)) {
+        Logger::warning(QString("Cannot open history index: %1").arg(index.errorString()));
+        return false;
+    }
+
+    QByteArray header = index.read(INDEX_HEADER_SIZE);
+    if (qFromLittleEndian<quint32>(header.constData()) != INDEX_MAGIC
+        || qFromLittleEndian<quint32>(header.constData() + 4) != INDEX_VERSION) {
+        index.close();
+        return rebuildIndex();
+    }
+    qint64 firstSeq = qFromLittleEndian<qint64>(header.constData() + 8);
+
+    QFile log(m_logPath);
+    if (!log.open(QIODevice::ReadWrite)) {
+        Logger::warning(QString("Cannot open history log: %1").arg(log.errorString()));
+        return false;
+    }
+
+    // Drop index entries that point past the end of the log (a crash between
+    // the two writes), then truncate any unindexed bytes at the end of the log
+    // Holes (offset -1) from failed writes are kept, so later sequence
+    // numbers stay in place
+    qint64 count = (index.size() - INDEX_HEADER_SIZE) / INDEX_ENTRY_SIZE;
+    qint64 logEnd = 0;
+    for (qint64 pos = count - 1; pos >= 0; --pos) {
+        index.seek(INDEX_HEADER_SIZE + pos * INDEX_ENTRY_SIZE);
+        qint64 offset = qFromLittleEndian<qint64>(index.read(INDEX_ENTRY_SIZE).constData());
+        if (offset < 0) {
+            continue;
+        }
+
+        log.seek(offset);
+        QByteArray recHeader = log.read(RECORD_HEADER_SIZE);
+        if (recHeader.size() == RECORD_HEADER_SIZE
+            && qFromLittleEndian<quint32>(recHeader.constData()) == RECORD_MAGIC) {
+            qint64 end = offset + RECORD_HEADER_SIZE + qFromLittleEndian<quint32>(recHeader.constData() + 4);
+            if (end <= log.size()) {
+                logEnd = end;
+                break;
+            }
+        }
+        count = pos;
+    }
+
+    index.resize(INDEX_HEADER_SIZE + count * INDEX_ENTRY_SIZE);
+    log.resize(logEnd);
+
+    m_firstSeq.storeRelease(firstSeq);
+    m_committedSeq.storeRelease(firstSeq + count);
+    return true;
+}
+
+void HistoryStore::loadTombstones()
+{
+    QFile file(m_tombstonePath);
+    if (!file.exists()) {
+        return;
+    }
+    if (!file.open(QIODevice::ReadWrite)) {
+        Logger::warning(QString("Cannot open history tombstones: %1").arg(file.errorString()));
+        return;
+    }
+
+    // Stop at the first damaged frame and drop the tail, like the log
+    const QByteArray data = file.readAll();
+    qint64 pos = 0;
+    while (pos + TOMBSTONE_HEADER_SIZE <= data.size()) {
+        if (qFromLittleEndian<quint32>(data.constData() + pos) != TOMBSTONE_MAGIC) {
+            break;
+        }
+        qint64 length = qFromLittleEndian<quint32>(data.constData() + pos + 4);
+        if (pos + TOMBSTONE_HEADER_SIZE + length > data.size()) {
+            break;
+        }
+        QCborValue value = QCborValue::fromCbor(data.mid(pos + TOMBSTONE_HEADER_SIZE, length));
+        if (!value.isMap()) {
+            break;
+        }
+        applyTombstone(value.toMap());
+        pos += TOMBSTONE_HEADER_SIZE + length;
+    }
+
+    if (pos < data.size()) {
+        file.resize(pos);
+    }
+}
+
+void HistoryStore::applyTombstone(const QCborMap& tombstone)
+{
+    const QString kind = tombstone.value(QStringLiteral("kind")).toString();
+    const qint64 seq = tombstone.value(QStringLiteral("seq")).toInteger();
+
+    QWriteLocker locker(&m_tombstoneLock);
+    if (kind == QLatin1String("clear")) {
+        m_clearedBefore = qMax(m_clearedBefore, seq);
+    } else if (kind == QLatin1String("record")) {
+        m_removedRecords.insert(seq);
+    }
+}
+
+void HistoryStore::addTombstone(const QCborMap& tombstone)
+{
+    applyTombstone(tombstone);
+    if (m_writer) {
+        m_writer->enqueueTombstone(tombstoneFrame(tombstone));
+    }
+}
+
+QList<QCborMap> HistoryStore::pruneTombstones(qint64 firstSeq)
+{
+    QWriteLocker locker(&m_tombstoneLock);
+    QList<QCborMap> kept;
+
+    if (m_clearedBefore > firstSeq) {
+        kept.append(QCborMap{{QStringLiteral("kind"), QStringLiteral("clear")},
+                             {QStringLiteral("seq"), m_clearedBefore}});
+    }
+
+    // A tombstone only matters while it can still match a stored record
+    for (auto it = m_removedRecords.begin(); it != m_removedRecords.end();) {
+        if (*it < qMax(firstSeq, m_clearedBefore)) {
+            it = m_removedRecords.erase(it);
+            continue;
+        }
+        kept.append(QCborMap{{QStringLiteral("kind"), QStringLiteral("record")},
+                             {QStringLiteral("seq"), *it}});
+        ++it;
+    }
+    return kept;
+}
+
+bool HistoryStore::isRemoved(qint64 seq) const
+{
+    QReadLocker locker(&m_tombstoneLock);
+    return seq < m_clearedBefore || m_removedRecords.contains(seq);
+}
+
+void HistoryStore::removeRecord(qint64 seq)
+{
+    addTombstone(QCborMap{{QStringLiteral("kind"), QStringLiteral("record")},
+                          {QStringLiteral("seq"), seq}});
+}
+
+qint64 HistoryStore::removeAll()
+{
+    addTombstone(QCborMap{{QStringLiteral("kind"), QStringLiteral("clear")},
+                          {QStringLiteral("seq"), m_nextSeq}});
+    return m_nextSeq;
+}
+
+qint64 HistoryStore::clearedBefore() const
+{
+    QReadLocker locker(&m_tombstoneLock);
+    return m_clearedBefore;
+}
+
+bool HistoryStore::rebuildIndex()
+{
+    // Scan the log from the start and stop at the first damaged record
+    QFile log(m_logPath);
+    if (!log.open(QIODevice::ReadWrite)) {
+        Logger::warning(QString("Cannot open history log: %1").arg(log.errorString()));
+        return false;
+    }
+
+    QFile index(m_indexPath);
+    if (!index.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        Logger::warning(QString("Cannot create history index: %1").arg(index.errorString()));
+        return false;
+    }
+
+    QByteArray entries = indexHeader(0);
+    qint64 offset = 0;
+    qint64 count = 0;
+    while (offset + RECORD_HEADER_SIZE <= log.size()) {
+        log.seek(offset);
+        QByteArray recHeader = log.read(RECORD_HEADER_SIZE);
+        if (qFromLittleEndian<quint32>(recHeader.constData()) != RECORD_MAGIC) {
+            break;
+        }
+        qint64 end = offset + RECORD_HEADER_SIZE + qFromLittleEndian<quint32>(recHeader.constData() + 4);
+        if (end > log.size()) {
+            break;
+        }
+        entries.append(indexEntry(offset, qFromLittleEndian<qint64>(recHeader.constData() + 8)));
+        offset = end;
+        ++count;
+    }
+
+    log.resize(offset);
+    index.write(entries);
+    syncFile(index);
+
+    if (count > 0) {
+        Logger::info(QString("Rebuilt notification history index (%1 records)").arg(count));
+    }
+
+    m_firstSeq.storeRelease(0);
+    m_committedSeq.storeRelease(count);
+    return true;
+}
+
+qint64 HistoryStore::append(const NotificationData& notification)
+{
+    if (!m_writer) {
+        return -1;
+    }
+
+    QByteArray payload = QCborMap::fromJsonObject(notification.toJson()).toCborValue().toCbor();
+    m_writer->enqueue(payload, notification.timestamp.toMSecsSinceEpoch());
+    return m_nextSeq++;
+}
+
+QList<HistoryRecord> HistoryStore::read(qint64 firstSeq, int count) const
+{
+    QList<qint64> sequences;
+    const qint64 begin = qMax(firstSeq, firstSequence());
+    const qint64 end = qMin(firstSeq + count, endSequence());
+    if (begin < end) {
+        sequences.reserve(end - begin);
+        for (qint64 seq = begin; seq < end; ++seq) {
+            sequences.append(seq);
+        }
+    }
+    return read(sequences);
+}
+
+QList<HistoryRecord> HistoryStore::read(const QList<qint64>& sequences) const
+{
+    QList<HistoryRecord> result;
+    if (sequences.isEmpty()) {
+        return result;
+    }
+
+    QReadLocker locker(&m_lock);
+    const qint64 base = m_firstSeq.loadAcquire();
+    const qint64 end = m_committedSeq.loadAcquire();
+
+    QFile index(m_indexPath);
+    QFile log(m_logPath);
+    if (!index.open(QIODevice::ReadOnly) || !log.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+
+    const qint64 indexSize = index.size();
+    const qint64 logSize = log.size();
+    const uchar* indexData = indexSize > 0 ? index.map(0, indexSize) : nullptr;
+    const uchar* logData = logSize > 0 ? log.map(0, logSize) : nullptr;
+    if (!indexData || !logData) {
+        return result;
+    }
+
+    // Sequences that were compacted away, removed, or fail validation are skipped
+    result.reserve(sequences.size());
+    for (qint64 seq : sequences) {
+        qint64 entryPos = INDEX_HEADER_SIZE + (seq - base) * INDEX_ENTRY_SIZE;
+        if (seq < base || seq >= end || entryPos + INDEX_ENTRY_SIZE > indexSize || isRemoved(seq)) {
+            continue;
+        }
+
+        // Holes left by failed writes have offset -1; a record whose header
+        // does not repeat the index entry's timestamp is not the one indexed
+        qint64 offset = qFromLittleEndian<qint64>(indexData + entryPos);
+        if (offset < 0 || offset + RECORD_HEADER_SIZE > logSize
+            || qFromLittleEndian<quint32>(logData + offset) != RECORD_MAGIC
+            || qFromLittleEndian<qint64>(logData + offset + 8) != qFromLittleEndian<qint64>(indexData + entryPos + 8)) {
+            continue;
+        }
+        qint64 length = qFromLittleEndian<quint32>(logData + offset + 4);
+        if (offset + RECORD_HEADER_SIZE + length > logSize) {
+            continue;
+        }
+
+        QByteArray payload = QByteArray::fromRawData(
+            reinterpret_cast<const char*>(logData + offset + RECORD_HEADER_SIZE), length);
+        QCborValue value = QCborValue::fromCbor(payload);
+        result.append({seq, NotificationData::fromJson(value.toMap().toJsonObject())});
+    }
+
+    return result;
+}
+
+QList<HistoryRecord> HistoryStore::readRecent(int count) const
+{
+    return read(endSequence() - count, count);
+}
+
+void HistoryStore::requestCompaction()
+{
+    if (m_writer) {
+        m_writer->requestCompaction();
+    }
+}
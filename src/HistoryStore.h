@@ -0,0 +1,111 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QReadWriteLock>
+#include <QAtomicInteger>
+#include "NotificationData.h"
+
+class QCborMap;
+class QTimer;
+class HistoryWriter;
+
+struct HistoryRecord {
+    qint64 seq;
+    NotificationData notification;
+};
+
+// Append-only on-disk history of every received notification.
+//
+// history.log holds length-prefixed CBOR records. history.idx starts with a
+// small header followed by one fixed-size entry (offset, timestamp) per
+// record, so it can be memory-mapped and addressed by sequence number.
+// Sequence numbers are stable across compaction, which only drops the
+// oldest records. Writes go through a background thread that batches
+// fsyncs; a record that fails to write leaves a hole in the index rather
+// than shifting later sequence numbers. Removals never touch the log:
+// history.tomb holds small tombstones (a single record deleted from the
+// history, or a "clear all" marker) that are loaded at open and filter
+// every read. Dismissing a live notification leaves its history alone.
+// Reads are safe from any thread.
+class HistoryStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HistoryStore(QObject *parent = nullptr);
+    ~HistoryStore();
+
+    bool open(const QString& directory = QString());
+    void close();
+    bool isOpen() const { return m_writer != nullptr; }
+    
+    // Queues a notification for writing; returns its sequence number or -1
+    qint64 append(const NotificationData& notification);
+    
+    // Range of records readable right now: [firstSequence, endSequence)
+    qint64 firstSequence() const { return m_firstSeq.loadAcquire(); }
+    qint64 endSequence() const { return m_committedSeq.loadAcquire(); }
+    
+    // Reads up to count records starting at firstSeq, oldest first
+    QList<HistoryRecord> read(qint64 firstSeq, int count) const;
+    // Reads the given records in order, skipping any that no longer exist
+    QList<HistoryRecord> read(const QList<qint64>& sequences) const;
+    // Reads the newest count records, oldest first
+    QList<HistoryRecord> readRecent(int count) const;
+    
+    // Tombstones: hide a single record, or everything appended so far
+    // (returns the marker sequence)
+    void removeRecord(qint64 seq);
+    qint64 removeAll();
+    // Records before this sequence were cleared with removeAll()
+    qint64 clearedBefore() const;
+    
+    void requestCompaction();
+    
+    static constexpr int MAX_RECORDS = 200000;
+    static constexpr int MAX_AGE_DAYS = 180;
+    static constexpr int COMPACTION_INTERVAL = 60 * 60 * 1000; // 1 hour
+
+signals:
+    // Emitted from the writer thread once records before firstSeq are gone
+    void compacted(qint64 firstSeq);
+    
+private:
+    friend class HistoryWriter;
+    
+    bool recover();
+    bool rebuildIndex();
+    // Completes a compaction interrupted after its commit point
+    bool finishCompaction();
+    void loadTombstones();
+    void applyTombstone(const QCborMap& tombstone);
+    void addTombstone(const QCborMap& tombstone);
+    // Drops tombstones made redundant by compaction; returns the rest
+    QList<QCborMap> pruneTombstones(qint64 firstSeq);
+    bool isRemoved(qint64 seq) const;
+    
+    QString m_logPath;
+    QString m_indexPath;
+    QString m_tombstonePath;
+    
+    // Readers take the lock shared; compaction takes it exclusively while
+    // swapping files. Appends only advance m_committedSeq.
+    mutable QReadWriteLock m_lock;
+    QAtomicInteger<qint64> m_firstSeq;
+    QAtomicInteger<qint64> m_committedSeq;
+    qint64 m_nextSeq;
+    
+    // Applied on the GUI thread, read from any thread
+    mutable QReadWriteLock m_tombstoneLock;
+    qint64 m_clearedBefore;
+    QSet<qint64> m_removedRecords;
+    
+    HistoryWriter* m_writer;
+    QTimer* m_compactionTimer;
+};
+
+#endif // HISTORYSTORE_H
@@ -3,6 +3,7 @@
 #include "NotificationManager.h"
 #include "AnimationManager.h"
 #include "NotificationPopupManager.h"
+#include "UpdateBatcher.h"
 
 #include <QApplication>
 #include <QSystemTrayIcon>
@@ -12,6 +13,7 @@
 #include <QShortcut>
 #include <QScreen>
 #include <QRect>
+#include <QTimer>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -19,18 +21,23 @@ MainWindow::MainWindow(QWidget *parent)
     , m_notificationManager(nullptr)
     , m_animationManager(nullptr)
     , m_popupManager(nullptr)
+    , m_updateBatcher(nullptr)
     , m_trayIcon(nullptr)
     , m_trayMenu(nullptr)
     , m_toggleAction(nullptr)
     , m_quitAction(nullptr)
     , m_connectAction(nullptr)
     , m_statusAction(nullptr)
+    , m_doNotDisturbAction(nullptr)
     , m_panelVisible(false)
 {
     setupUI();
     setupTrayIcon();
     setupHotkeys();
     
+    // Create the popup and panel surfaces once startup work has drained
+    QTimer::singleShot(0, this, &MainWindow::warmUp);
+    
     // Hide the main window - we only use the notification panel
     hide();
 }
@@ -59,15 +66,30 @@ void MainWindow::setupUI()
     // Create popup manager
     m_popupManager = new NotificationPopupManager(this);
     
-    // Connect signals
-    connect(m_notificationManager, &NotificationManager::notificationReceived,
-            m_notificationPanel, &NotificationPanel::addNotification);
+    // Coalesce manager signals so bursts reach the UI once per frame
+    m_updateBatcher = new UpdateBatcher(this);
+    m_updateBatcher->setMaxLatency(UpdateBatcher::maxLatencyFromSettings());
+    
+    connect(m_notificationManager, &NotificationManager::notificationUpdated,
+            m_updateBatcher, &UpdateBatcher::addUpdated);
     connect(m_notificationManager, &NotificationManager::notificationRemoved,
-            m_notificationPanel, &NotificationPanel::removeNotification);
+            m_updateBatcher, &UpdateBatcher::addRemoved);
+    connect(m_notificationManager, &NotificationManager::notificationsCleared,
+            m_updateBatcher, &UpdateBatcher::addCleared);
+    connect(m_notificationManager, &NotificationManager::notificationReceived,
+            m_updateBatcher, &UpdateBatcher::addReceived);
+    
+    // Connect batched signals to the panel
+    connect(m_updateBatcher, &UpdateBatcher::notificationsUpdated,
+            m_notificationPanel, &NotificationPanel::addNotifications);
+    connect(m_updateBatcher, &UpdateBatcher::notificationsRemoved,
+            m_notificationPanel, &NotificationPanel::removeNotifications);
+    connect(m_updateBatcher, &UpdateBatcher::notificationsCleared,
+            m_notificationPanel, &NotificationPanel::clearAllNotifications);
     
     // Connect popup manager to show popups for new notifications
-    connect(m_notificationManager, &NotificationManager::notificationReceived,
-            m_popupManager, &NotificationPopupManager::showNotificationPopup);
+    connect(m_updateBatcher, &UpdateBatcher::notificationsReceived,
+            m_popupManager, &NotificationPopupManager::showNotificationPopups);
     
     // Connect network status signals
     connect(m_notificationManager, &NotificationManager::serverConnected,
@@ -77,6 +99,9 @@ void MainWindow::setupUI()
     connect(m_notificationManager, &NotificationManager::connectionError,
             this, &MainWindow::onConnectionError);
     
+    // Bring back the newest notifications from the previous session
+    m_notificationManager->restoreHistory();
+    
     // Start network client
     m_notificationManager->startNetworkClient();
     
@@ -94,6 +119,7 @@ void MainWindow::setupTrayIcon()
     
     m_trayMenu = new QMenu(this);
     m_trayMenu->addAction(m_toggleAction);
+    m_trayMenu->addAction(m_doNotDisturbAction);
     m_trayMenu->addSeparator();
     m_trayMenu->addAction(m_statusAction);
     m_trayMenu->addAction(m_connectAction);
@@ -123,6 +149,12 @@ void MainWindow::createActions()
     m_toggleAction = new QAction("Toggle Notifications", this);
     connect(m_toggleAction, &QAction::triggered, this, &MainWindow::togglePanel);
     
+    // Popups queue silently while this is checked
+    m_doNotDisturbAction = new QAction("Do Not Disturb", this);
+    m_doNotDisturbAction->setCheckable(true);
+    m_doNotDisturbAction->setChecked(m_popupManager->doNotDisturb());
+    connect(m_doNotDisturbAction, &QAction::toggled, m_popupManager, &NotificationPopupManager::setDoNotDisturb);
+    
     m_statusAction = new QAction("Status: Searching...", this);
     m_statusAction->setEnabled(false);
     
@@ -135,6 +167,12 @@ void MainWindow::createActions()
     connect(m_quitAction, &QAction::triggered, QApplication::instance(), &QApplication::quit);
 }
 
+void MainWindow::warmUp()
+{
+    m_popupManager->warmUp();
+    m_animationManager->warmUp();
+}
+
 void MainWindow::togglePanel()
 {
     if (m_panelVisible) {
@@ -150,6 +188,8 @@ void MainWindow::showPanel()
         return;
     }
     
+    // Rows released while hidden come back before the slide-in snapshot
+    m_notificationPanel->restoreIfTrimmed();
     m_animationManager->slideIn();
     m_panelVisible = true;
 }
@@ -10,6 +10,7 @@ class NotificationPanel;
 class NotificationManager;
 class AnimationManager;
 class NotificationPopupManager;
+class UpdateBatcher;
 
 class MainWindow : public QMainWindow
 {
@@ -30,6 +31,7 @@ private slots:
     void onServerConnected();
     void onServerDisconnected();
     void onConnectionError(const QString& error);
+    void warmUp();
 
 private:
     void setupUI();
@@ -41,6 +43,7 @@ private:
     NotificationManager* m_notificationManager;
     AnimationManager* m_animationManager;
     NotificationPopupManager* m_popupManager;
+    UpdateBatcher* m_updateBatcher;
     
     QSystemTrayIcon* m_trayIcon;
     QMenu* m_trayMenu;
@@ -49,6 +52,7 @@ private:
     QAction* m_quitAction;
     QAction* m_connectAction;
     QAction* m_statusAction;
+    QAction* m_doNotDisturbAction;
     
     bool m_panelVisible;
 };
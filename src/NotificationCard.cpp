@@ -1,14 +1,28 @@
 #include "NotificationCard.h"
+#include "BackgroundCache.h"
+#include "BlobCache.h"
+#include "CardRenderer.h"
+#include "GroupBodiesModel.h"
+#include "Logger.h"
+#include "RelativeTimeTicker.h"
 
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QLabel>
+#include <QListView>
+#include <QScrollBar>
 #include <QPushButton>
 #include <QPainter>
+#include <QPixmap>
 #include <QDateTime>
 #include <QEvent>
 #include <QEnterEvent>
 #include <QMouseEvent>
+#include <QResizeEvent>
+#include <QStyle>
+#include <QElapsedTimer>
+#include <climits>
+#include <utility>
 
 NotificationCard::NotificationCard(const NotificationData& notification, QWidget *parent)
     : QWidget(parent)
@@ -16,16 +30,23 @@ NotificationCard::NotificationCard(const NotificationData& notification, QWidget
     , m_mainLayout(nullptr)
     , m_headerLayout(nullptr)
     , m_actionLayout(nullptr)
+    , m_iconLabel(nullptr)
     , m_appNameLabel(nullptr)
     , m_timeLabel(nullptr)
     , m_titleLabel(nullptr)
     , m_bodyLabel(nullptr)
+    , m_imageLabel(nullptr)
     , m_removeButton(nullptr)
     , m_actionIndicator(nullptr)
     , m_actionWidget(nullptr)
     , m_actionButtonsLayout(nullptr)
+    , m_bodyList(nullptr)
+    , m_bodiesModel(nullptr)
+    , m_earlierLabel(nullptr)
     , m_inputWidget(nullptr)
+    , m_inputLayout(nullptr)
     , m_replyInput(nullptr)
+    , m_inputButtonsLayout(nullptr)
     , m_sendButton(nullptr)
     , m_cancelButton(nullptr)
     , m_isHovered(false)
@@ -33,11 +54,17 @@ NotificationCard::NotificationCard(const NotificationData& notification, QWidget
     , m_bodiesExpanded(false)
     , m_inputVisible(false)
 {
+    QElapsedTimer timer;
+    timer.start();
+    
     setupUI();
     
     // Set widget properties - take only the minimum height needed
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
     setMouseTracking(true);
+    
+    // Construction cost, for comparing styling approaches (polish happens on first show)
+    Logger::debug(QString("NotificationCard built in %1 us").arg(timer.nsecsElapsed() / 1000));
 }
 
 NotificationCard::~NotificationCard()
@@ -47,9 +74,8 @@ NotificationCard::~NotificationCard()
 
 void NotificationCard::updateNotificationData(const NotificationData& newData)
 {
+    bool wasExpanded = isExpanded();
     m_notificationData = newData;
-    m_actionsVisible = false;
-    m_bodiesExpanded = false;
     
     // Update UI elements with new data
     if (m_appNameLabel) {
@@ -57,11 +83,23 @@ void NotificationCard::updateNotificationData(const NotificationData& newData)
     }
     if (m_titleLabel) {
         m_titleLabel->setText(m_notificationData.title);
+        m_titleLabel->setVisible(!m_notificationData.title.isEmpty());
     }
     if (m_bodyLabel) {
         m_bodyLabel->setText(m_notificationData.getDisplayBody());
     }
+    if (m_bodiesExpanded && m_notificationData.isGrouped()) {
+        // An expanded group stays expanded; new bodies are inserted at the top
+        updateBodyList();
+    } else {
+        m_bodiesExpanded = false;
+        teardownBodyList();
+        if (m_bodyLabel) {
+            m_bodyLabel->setVisible(!m_notificationData.body.isEmpty());
+        }
+    }
     updateTimeLabel();
+    updatePictures();
     
     // Update action indicator visibility based on actions or grouping
     if (m_actionIndicator) {
@@ -69,7 +107,34 @@ void NotificationCard::updateNotificationData(const NotificationData& newData)
         m_actionIndicator->setVisible(shouldShowIndicator);
     }
 
-    setupActionButtons();
+    updateActionButtons();
+    
+    // Keep the visible widgets and the expanded flags in agreement
+    if (m_actionsVisible && m_notificationData.actions.isEmpty()) {
+        hideActions();
+    }
+    if (m_inputVisible) {
+        bool inputActionKept = false;
+        for (const NotificationAction& action : m_notificationData.actions) {
+            inputActionKept = inputActionKept || action.key == m_currentActionKey;
+        }
+        if (!inputActionKept) {
+            hideInput();
+        }
+    }
+    updateCardHeight();
+    
+    if (wasExpanded != isExpanded()) {
+        emit expandedChanged(isExpanded());
+    }
+}
+
+void NotificationCard::collapse()
+{
+    hideActions();
+    hideBodies();
+    hideInput();
+    m_isHovered = false;
 }
 
 void NotificationCard::setupUI()
@@ -82,70 +147,45 @@ void NotificationCard::setupUI()
     m_headerLayout = new QHBoxLayout();
     m_headerLayout->setSpacing(8);
     
+    // App or contact icon, same size as in the painted rows
+    m_iconLabel = new QLabel(this);
+    m_iconLabel->setObjectName("iconLabel");
+    m_iconLabel->setFixedSize(CardRenderer::ICON_SIZE, CardRenderer::ICON_SIZE);
+    m_iconLabel->setAlignment(Qt::AlignCenter);
+    m_headerLayout->addWidget(m_iconLabel);
+    
     // App name label
     m_appNameLabel = new QLabel(m_notificationData.appName, this);
-    m_appNameLabel->setStyleSheet(
-        "QLabel {"
-        "    color: rgba(255, 255, 255, 0.8);"
-        "    font-size: 12px;"
-        "    font-weight: bold;"
-        "}"
-    );
+    m_appNameLabel->setObjectName("appNameLabel");
     m_headerLayout->addWidget(m_appNameLabel);
     
-    // Action indicator (down arrow) - show if there are actions OR grouped messages
-    if (!m_notificationData.actions.isEmpty() || m_notificationData.isGrouped()) {
-        m_actionIndicator = new QLabel("⌄", this);
-        m_actionIndicator->setStyleSheet(
-            "QLabel {"
-            "    color: rgba(255, 255, 255, 0.6);"
-            "    font-size: 14px;"
-            "    font-weight: bold;"
-            "    padding: 2px;"
-            "}"
-            "QLabel:hover {"
-            "    color: rgba(255, 255, 255, 0.8);"
-            "}"
-        );
-        m_actionIndicator->setCursor(Qt::PointingHandCursor);
-        m_actionIndicator->setMouseTracking(true);
-        m_actionIndicator->installEventFilter(this);
-        m_headerLayout->addWidget(m_actionIndicator);
-    }
+    // Action indicator (down arrow) - show if there are actions OR grouped messages.
+    // Always created so a recycled card can be rebound to any notification.
+    m_actionIndicator = new QLabel("⌄", this);
+    m_actionIndicator->setObjectName("actionIndicator");
+    m_actionIndicator->setCursor(Qt::PointingHandCursor);
+    m_actionIndicator->setMouseTracking(true);
+    m_actionIndicator->installEventFilter(this);
+    m_actionIndicator->setVisible(!m_notificationData.actions.isEmpty() || m_notificationData.isGrouped());
+    m_headerLayout->addWidget(m_actionIndicator);
     
     m_headerLayout->addStretch(); // Push time and button to the right
     
     // Time label
     m_timeLabel = new QLabel(this);
     updateTimeLabel();
-    m_timeLabel->setStyleSheet(
-        "QLabel {"
-        "    color: rgba(255, 255, 255, 0.5);"
-        "    font-size: 10px;"
-        "}"
-    );
+    m_timeLabel->setObjectName("timeLabel");
     m_headerLayout->addWidget(m_timeLabel);
+    connect(RelativeTimeTicker::instance(), &RelativeTimeTicker::tick, this, [this]() {
+        if (isVisible()) {
+            updateTimeLabel();
+        }
+    });
     
     // Remove button
     m_removeButton = new QPushButton("×", this);
     m_removeButton->setFixedSize(20, 20);
-    m_removeButton->setStyleSheet(
-        "QPushButton {"
-        "    background-color: transparent;"
-        "    border: none;"
-        "    color: rgba(255, 255, 255, 0.6);"
-        "    font-size: 16px;"
-        "    font-weight: bold;"
-        "    border-radius: 10px;"
-        "}"
-        "QPushButton:hover {"
-        "    background-color: rgba(255, 255, 255, 0.1);"
-        "    color: rgba(255, 255, 255, 0.9);"
-        "}"
-        "QPushButton:pressed {"
-        "    background-color: rgba(255, 255, 255, 0.2);"
-        "}"
-    );
+    m_removeButton->setObjectName("removeButton");
     connect(m_removeButton, &QPushButton::clicked, this, &NotificationCard::onRemoveClicked);
     m_headerLayout->addWidget(m_removeButton);
     m_mainLayout->addLayout(m_headerLayout);
@@ -153,54 +193,93 @@ void NotificationCard::setupUI()
     m_contentLayout = new QVBoxLayout();
     m_contentLayout->setContentsMargins(0, 0, 0, 0);
     m_contentLayout->setSpacing(4);
-    m_mainLayout->addLayout(m_contentLayout);
-
-    // Title label
-    if (!m_notificationData.title.isEmpty()) {
-        m_titleLabel = new QLabel(m_notificationData.title, this);
-        m_titleLabel->setWordWrap(true);
-        m_titleLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Maximum);
-        m_titleLabel->setStyleSheet(
-            "QLabel {"
-            "    color: white;"
-            "    font-size: 14px;"
-            "    font-weight: bold;"
-            "}"
-        );
-        m_contentLayout->addWidget(m_titleLabel);
-    }
-    
-    // Body label  
-    if (!m_notificationData.body.isEmpty()) {
-        m_bodyLabel = new QLabel(m_notificationData.getDisplayBody(), this);
-        m_bodyLabel->setWordWrap(true);
-        m_bodyLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum);
-        m_bodyLabel->setStyleSheet(
-            "QLabel {"
-            "    color: rgba(255, 255, 255, 0.8);"
-            "    font-size: 12px;"
-            "    line-height: 1.4;"
-            "}"
-        );
-        m_contentLayout->addWidget(m_bodyLabel);
-    }
-    
-    // Setup action buttons (initially hidden)
-    setupActionButtons();
-    
-    // Setup input field (initially hidden)
-    setupInputField();
+    
+    // Text on the left, picture on the right
+    QHBoxLayout* contentRow = new QHBoxLayout();
+    contentRow->setContentsMargins(0, 0, 0, 0);
+    contentRow->setSpacing(8);
+    contentRow->addLayout(m_contentLayout, 1);
+    m_imageLabel = new QLabel(this);
+    m_imageLabel->setObjectName("imageLabel");
+    m_imageLabel->setFixedSize(CardRenderer::IMAGE_SIZE, CardRenderer::IMAGE_SIZE);
+    m_imageLabel->setAlignment(Qt::AlignCenter);
+    contentRow->addWidget(m_imageLabel, 0, Qt::AlignTop);
+    m_mainLayout->addLayout(contentRow);
+
+    // Title label, hidden while empty
+    m_titleLabel = new QLabel(m_notificationData.title, this);
+    m_titleLabel->setWordWrap(true);
+    m_titleLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Maximum);
+    m_titleLabel->setObjectName("titleLabel");
+    m_titleLabel->setVisible(!m_notificationData.title.isEmpty());
+    m_contentLayout->addWidget(m_titleLabel);
+    
+    // Body label, hidden while empty
+    m_bodyLabel = new QLabel(m_notificationData.getDisplayBody(), this);
+    m_bodyLabel->setWordWrap(true);
+    m_bodyLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum);
+    m_bodyLabel->setObjectName("bodyLabel");
+    m_bodyLabel->setVisible(!m_notificationData.body.isEmpty());
+    m_contentLayout->addWidget(m_bodyLabel);
+    
+    // Pictures decode off-thread and are filled in when ready
+    updatePictures();
+    connect(BlobCache::instance(), &BlobCache::imageReady, this, [this](const QString& hash) {
+        if (hash == m_notificationData.iconHash || hash == m_notificationData.imageHash) {
+            updatePictures();
+        }
+    });
+    
+    // Action buttons and the reply input are built on first use, see
+    // showActions() and showInput()
     
     updateGeometry();
 }
 
+void NotificationCard::updatePictures()
+{
+    // The labels keep their size while the pictures load, so the card does not resize
+    BlobCache* blobs = BlobCache::instance();
+    qreal dpr = devicePixelRatioF();
+    
+    QImage icon = blobs->image(m_notificationData.iconHash, m_iconLabel->size(), dpr);
+    m_iconLabel->setPixmap(icon.isNull() ? QPixmap() : QPixmap::fromImage(icon));
+    m_iconLabel->setVisible(!m_notificationData.iconHash.isEmpty());
+    
+    QImage image = blobs->image(m_notificationData.imageHash, m_imageLabel->size(), dpr);
+    m_imageLabel->setPixmap(image.isNull() ? QPixmap() : QPixmap::fromImage(image));
+    m_imageLabel->setVisible(!m_notificationData.imageHash.isEmpty());
+}
+
 void NotificationCard::updateTimeLabel()
 {
     if (!m_timeLabel) return;
     
-    // Show actual time instead of relative time to avoid needing periodic updates
-    QString timeText = m_notificationData.timestamp.toString("hh:mm");
-    m_timeLabel->setText(timeText);
+    m_timeLabel->setText(RelativeTimeTicker::instance()->format(m_notificationData.timestamp));
+}
+
+void NotificationCard::showEvent(QShowEvent *event)
+{
+    // Only visible cards follow the shared clock; pooled cards stay idle
+    RelativeTimeTicker::instance()->subscribe(this);
+    updateTimeLabel();
+    QWidget::showEvent(event);
+}
+
+void NotificationCard::hideEvent(QHideEvent *event)
+{
+    RelativeTimeTicker::instance()->unsubscribe(this);
+    QWidget::hideEvent(event);
+}
+
+void NotificationCard::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    
+    // Wrapped bodies take more or fewer lines at the new width
+    if (m_bodyList && event->size().width() != event->oldSize().width()) {
+        updateBodyListHeight();
+    }
 }
 
 void NotificationCard::onRemoveClicked()
@@ -212,16 +291,9 @@ void NotificationCard::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event)
     
+    // Draw card background from the cached nine-patch
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    
-    // Draw card background
-    QColor backgroundColor = m_isHovered ? 
-        QColor(60, 60, 60, 200) : QColor(45, 45, 45, 180);
-    
-    painter.setBrush(backgroundColor);
-    painter.setPen(QPen(QColor(255, 255, 255, m_isHovered ? 40 : 20), 1));
-    painter.drawRoundedRect(rect().adjusted(1, 1, -1, -1), 8, 8);
+    BackgroundCache::draw(&painter, rect(), BackgroundCache::cardStyle(m_isHovered));
 }
 
 void NotificationCard::enterEvent(QEnterEvent *event)
@@ -242,55 +314,105 @@ void NotificationCard::leaveEvent(QEvent *event)
 
 void NotificationCard::setupActionButtons()
 {
-    if (m_notificationData.actions.isEmpty()) {
-        return; // No actions to set up
+    if (m_actionWidget) {
+        return;
     }
     
-    // Create action widget container
+    // Create action widget container; its buttons follow the data
     m_actionWidget = new QWidget(this);
     m_actionButtonsLayout = new QHBoxLayout(m_actionWidget);
     m_actionButtonsLayout->setContentsMargins(0, 5, 0, 0);
     m_actionButtonsLayout->setSpacing(8);
+    m_actionButtonsLayout->addStretch();
+    
+    // Actions sit above the reply input if that already exists
+    int index = m_inputWidget ? m_mainLayout->indexOf(m_inputWidget) : -1;
+    m_mainLayout->insertWidget(index, m_actionWidget);
+    
+    updateActionButtons();
+}
+
+void NotificationCard::teardownActionButtons()
+{
+    if (!m_actionWidget) {
+        return;
+    }
+    
+    // Deferred: this can run from inside one of the action buttons' clicked()
+    m_mainLayout->removeWidget(m_actionWidget);
+    m_actionWidget->hide();
+    m_actionWidget->deleteLater();
+    m_actionWidget = nullptr;
+    m_actionButtonsLayout = nullptr;
+    m_actionButtons.clear();
+}
+
+void NotificationCard::updateActionButtons()
+{
+    if (!m_actionWidget) {
+        return;
+    }
+    
+    // Diff against the current buttons by action key so a merge that keeps
+    // the same actions touches no widgets at all
+    QList<QPushButton*> buttons;
+    buttons.reserve(m_notificationData.actions.size());
     
-    // Create buttons for each action
     for (const NotificationAction& action : m_notificationData.actions) {
-        QPushButton* button = new QPushButton(action.title, m_actionWidget);
-        button->setProperty("actionKey", action.key);
-        button->setProperty("actionType", action.type);
-        
-        button->setStyleSheet(
-            "QPushButton {"
-            "    background-color: rgba(70, 130, 180, 0.8);"
-            "    border: 1px solid rgba(255, 255, 255, 0.2);"
-            "    border-radius: 4px;"
-            "    color: white;"
-            "    font-size: 11px;"
-            "    padding: 4px 8px;"
-            "    min-width: 60px;"
-            "}"
-            "QPushButton:hover {"
-            "    background-color: rgba(70, 130, 180, 1.0);"
-            "    border: 1px solid rgba(255, 255, 255, 0.4);"
-            "}"
-            "QPushButton:pressed {"
-            "    background-color: rgba(50, 110, 160, 1.0);"
-            "}"
-        );
+        QPushButton* button = nullptr;
+        for (int i = 0; i < m_actionButtons.size(); ++i) {
+            if (m_actionButtons[i]->property("actionKey").toString() == action.key) {
+                button = m_actionButtons.takeAt(i);
+                break;
+            }
+        }
         
-        connect(button, &QPushButton::clicked, this, &NotificationCard::onActionButtonClicked);
-        m_actionButtonsLayout->addWidget(button);
-        m_actionButtons.append(button);
+        if (!button) {
+            button = createActionButton(action);
+        } else {
+            if (button->text() != action.title) {
+                button->setText(action.title);
+            }
+            button->setProperty("actionType", action.type);
+        }
+        buttons.append(button);
     }
     
-    m_actionButtonsLayout->addStretch();
-    m_mainLayout->addWidget(m_actionWidget);
+    // Whatever is left has no matching action any more
+    for (QPushButton* button : std::as_const(m_actionButtons)) {
+        m_actionButtonsLayout->removeWidget(button);
+        delete button;
+    }
     
-    // Initially hidden
-    m_actionWidget->hide();
+    // Match the order of the actions; the trailing stretch stays last
+    for (int i = 0; i < buttons.size(); ++i) {
+        if (m_actionButtonsLayout->indexOf(buttons[i]) != i) {
+            m_actionButtonsLayout->removeWidget(buttons[i]);
+            m_actionButtonsLayout->insertWidget(i, buttons[i]);
+        }
+    }
+    
+    m_actionButtons = buttons;
+}
+
+QPushButton* NotificationCard::createActionButton(const NotificationAction& action)
+{
+    QPushButton* button = new QPushButton(action.title, m_actionWidget);
+    button->setProperty("actionKey", action.key);
+    button->setProperty("actionType", action.type);
+    
+    button->setObjectName("actionButton");
+    
+    connect(button, &QPushButton::clicked, this, &NotificationCard::onActionButtonClicked);
+    return button;
 }
 
 void NotificationCard::setupInputField()
 {
+    if (m_inputWidget) {
+        return;
+    }
+    
     // Create input widget container
     m_inputWidget = new QWidget(this);
     m_inputLayout = new QVBoxLayout(m_inputWidget);
@@ -300,20 +422,7 @@ void NotificationCard::setupInputField()
     // Create reply input field
     m_replyInput = new QLineEdit(m_inputWidget);
     m_replyInput->setPlaceholderText("Type your reply...");
-    m_replyInput->setStyleSheet(
-        "QLineEdit {"
-        "    background-color: rgba(60, 60, 60, 0.8);"
-        "    border: 1px solid rgba(255, 255, 255, 0.2);"
-        "    border-radius: 4px;"
-        "    color: white;"
-        "    font-size: 12px;"
-        "    padding: 6px 8px;"
-        "}"
-        "QLineEdit:focus {"
-        "    border: 1px solid rgba(70, 130, 180, 0.8);"
-        "    background-color: rgba(70, 70, 70, 0.9);"
-        "}"
-    );
+    m_replyInput->setObjectName("replyInput");
     
     // Connect return key to send
     connect(m_replyInput, &QLineEdit::returnPressed, this, &NotificationCard::onInputReturnPressed);
@@ -326,45 +435,11 @@ void NotificationCard::setupInputField()
     
     // Create send button
     m_sendButton = new QPushButton("Send", m_inputWidget);
-    m_sendButton->setStyleSheet(
-        "QPushButton {"
-        "    background-color: rgba(70, 130, 180, 0.8);"
-        "    border: 1px solid rgba(255, 255, 255, 0.2);"
-        "    border-radius: 4px;"
-        "    color: white;"
-        "    font-size: 11px;"
-        "    padding: 4px 12px;"
-        "    min-width: 50px;"
-        "}"
-        "QPushButton:hover {"
-        "    background-color: rgba(70, 130, 180, 1.0);"
-        "    border: 1px solid rgba(255, 255, 255, 0.4);"
-        "}"
-        "QPushButton:pressed {"
-        "    background-color: rgba(50, 110, 160, 1.0);"
-        "}"
-    );
+    m_sendButton->setObjectName("sendButton");
     
     // Create cancel button
     m_cancelButton = new QPushButton("Cancel", m_inputWidget);
-    m_cancelButton->setStyleSheet(
-        "QPushButton {"
-        "    background-color: rgba(120, 120, 120, 0.6);"
-        "    border: 1px solid rgba(255, 255, 255, 0.2);"
-        "    border-radius: 4px;"
-        "    color: white;"
-        "    font-size: 11px;"
-        "    padding: 4px 12px;"
-        "    min-width: 50px;"
-        "}"
-        "QPushButton:hover {"
-        "    background-color: rgba(140, 140, 140, 0.8);"
-        "    border: 1px solid rgba(255, 255, 255, 0.4);"
-        "}"
-        "QPushButton:pressed {"
-        "    background-color: rgba(100, 100, 100, 0.8);"
-        "}"
-    );
+    m_cancelButton->setObjectName("cancelButton");
     
     // Connect button signals
     connect(m_sendButton, &QPushButton::clicked, this, &NotificationCard::onSendButtonClicked);
@@ -382,69 +457,206 @@ void NotificationCard::setupInputField()
     
     // Add input widget to main layout
     m_mainLayout->addWidget(m_inputWidget);
+}
+
+void NotificationCard::teardownInputField()
+{
+    if (!m_inputWidget) {
+        return;
+    }
     
-    // Initially hidden
+    // Deferred: this runs from inside the send and cancel buttons' clicked()
+    m_mainLayout->removeWidget(m_inputWidget);
     m_inputWidget->hide();
+    m_inputWidget->deleteLater();
+    m_inputWidget = nullptr;
+    m_inputLayout = nullptr;
+    m_replyInput = nullptr;
+    m_inputButtonsLayout = nullptr;
+    m_sendButton = nullptr;
+    m_cancelButton = nullptr;
 }
 
 void NotificationCard::showActions()
 {
-    if (m_actionWidget && !m_notificationData.actions.isEmpty()) {
+    if (!m_notificationData.actions.isEmpty()) {
+        setupActionButtons();
         m_actionWidget->show();
         m_actionsVisible = true;
-        updateGeometry();
+        updateCardHeight();
     }
 }
 
 void NotificationCard::hideActions()
 {
     if (m_actionWidget) {
-        m_actionWidget->hide();
+        teardownActionButtons();
         m_actionsVisible = false;
-        updateGeometry();
+        updateCardHeight();
     }
 }
 
 void NotificationCard::showBodies()
 {
     if (m_bodyLabel && m_notificationData.isGrouped()) {
-        // Show all bodies formatted
-        m_bodyLabel->setText(m_notificationData.getAllBodiesFormatted());
+        // The list replaces the label, which only ever shows the latest body
+        setupBodyList();
+        updateBodyList();
+        m_bodyLabel->hide();
         m_bodiesExpanded = true;
-        updateGeometry();
+        updateCardHeight();
     }
 }
 
 void NotificationCard::hideBodies()
 {
-    if (m_bodyLabel && m_notificationData.isGrouped()) {
-        // Show only the latest body
-        m_bodyLabel->setText(m_notificationData.getDisplayBody());
+    if (m_bodyList) {
+        teardownBodyList();
+        m_bodyLabel->setVisible(!m_notificationData.body.isEmpty());
         m_bodiesExpanded = false;
-        updateGeometry();
+        updateCardHeight();
     }
 }
 
-void NotificationCard::showInput(const QString& actionKey)
+void NotificationCard::setupBodyList()
 {
-    if (m_inputWidget) {
-        m_currentActionKey = actionKey;
-        m_replyInput->clear();
-        m_replyInput->setFocus();
-        m_inputWidget->show();
-        m_inputVisible = true;
-        
-        // Hide action buttons when showing input
-        hideActions();
-        
+    if (m_bodyList) {
+        return;
+    }
+    
+    m_bodiesModel = new GroupBodiesModel(this);
+    
+    // Rows are laid out in batches and only visible ones are painted, so a
+    // large group expands without measuring or rendering every body up front
+    m_bodyList = new QListView(this);
+    m_bodyList->setObjectName("bodyList");
+    m_bodyList->setModel(m_bodiesModel);
+    m_bodyList->setWordWrap(true);
+    m_bodyList->setLayoutMode(QListView::Batched);
+    m_bodyList->setBatchSize(BODY_LIST_BATCH_SIZE);
+    m_bodyList->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    m_bodyList->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    m_bodyList->setSelectionMode(QAbstractItemView::NoSelection);
+    m_bodyList->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_bodyList->setFocusPolicy(Qt::NoFocus);
+    m_bodyList->setFrameShape(QFrame::NoFrame);
+    m_bodyList->setSpacing(2);
+    m_bodyList->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    
+    // Bodies arrive one at a time; only the changed rows are laid out again
+    connect(m_bodiesModel, &QAbstractItemModel::rowsInserted, this, [this]() {
+        updateBodyListHeight();
+    });
+    connect(m_bodiesModel, &QAbstractItemModel::rowsRemoved, this, [this]() {
+        updateBodyListHeight();
+    });
+    connect(m_bodiesModel, &QAbstractItemModel::modelReset, this, [this]() {
+        updateBodyListHeight();
+    });
+    
+    m_earlierLabel = new QLabel(this);
+    m_earlierLabel->setObjectName("earlierLabel");
+    
+    // Directly after the body label, above the action buttons
+    int index = m_contentLayout->indexOf(m_bodyLabel) + 1;
+    m_contentLayout->insertWidget(index, m_bodyList);
+    m_contentLayout->insertWidget(index + 1, m_earlierLabel);
+}
+
+void NotificationCard::teardownBodyList()
+{
+    if (!m_bodyList) {
+        return;
+    }
+    
+    m_contentLayout->removeWidget(m_bodyList);
+    m_contentLayout->removeWidget(m_earlierLabel);
+    m_bodyList->hide();
+    m_earlierLabel->hide();
+    m_bodyList->deleteLater();
+    m_earlierLabel->deleteLater();
+    m_bodiesModel->deleteLater();
+    m_bodyList = nullptr;
+    m_bodiesModel = nullptr;
+    m_earlierLabel = nullptr;
+}
+
+void NotificationCard::updateBodyList()
+{
+    if (!m_bodyList) {
+        return;
+    }
+    
+    // A scrolled list keeps its place when a new body is inserted above it
+    QScrollBar* scrollBar = m_bodyList->verticalScrollBar();
+    bool atTop = scrollBar->value() == scrollBar->minimum();
+    int fromBottom = scrollBar->maximum() - scrollBar->value();
+    
+    m_bodiesModel->setBodies(m_notificationData.bodies);
+    
+    if (atTop) {
+        m_bodyList->scrollToTop();
+    } else {
+        scrollBar->setValue(scrollBar->maximum() - fromBottom);
+    }
+    
+    // Only the newest MAX_GROUP_BODIES bodies are kept with the group
+    qsizetype earlier = m_notificationData.groupCount - m_notificationData.bodies.size();
+    m_earlierLabel->setText(earlier == 1 ? QString("1 earlier message")
+                                         : QString("%1 earlier messages").arg(earlier));
+    m_earlierLabel->setVisible(earlier > 0);
+}
+
+void NotificationCard::updateBodyListHeight()
+{
+    if (!m_bodyList) {
+        return;
+    }
+    
+    // Measure rows from the top only until the list reaches its maximum
+    // height; beyond that it scrolls and the rest are measured lazily
+    int width = m_bodyList->viewport()->width();
+    if (width <= 0) {
+        width = qMax(1, this->width() - 2 * CARD_MARGIN);
+    }
+    const QFontMetrics metrics = m_bodyList->fontMetrics();
+    int spacing = m_bodyList->spacing();
+    int height = 0;
+    int rows = m_bodiesModel->rowCount();
+    for (int row = 0; row < rows && height < MAX_BODY_LIST_HEIGHT; ++row) {
+        const QString text = m_bodiesModel->index(row).data().toString();
+        QRect bounds = metrics.boundingRect(QRect(0, 0, width - 2 * spacing, INT_MAX),
+                                            Qt::TextWordWrap, text);
+        height += bounds.height() + 2 * spacing;
+    }
+    height = qMin(height, MAX_BODY_LIST_HEIGHT);
+    
+    if (m_bodyList->height() != height) {
+        m_bodyList->setFixedHeight(height);
         updateCardHeight();
     }
 }
 
+void NotificationCard::showInput(const QString& actionKey)
+{
+    setupInputField();
+    
+    m_currentActionKey = actionKey;
+    m_replyInput->clear();
+    m_inputWidget->show();
+    m_replyInput->setFocus();
+    m_inputVisible = true;
+    
+    // Hide action buttons when showing input
+    hideActions();
+    
+    updateCardHeight();
+}
+
 void NotificationCard::hideInput()
 {
     if (m_inputWidget) {
-        m_inputWidget->hide();
+        teardownInputField();
         m_inputVisible = false;
         m_currentActionKey.clear();
         
@@ -483,16 +695,20 @@ bool NotificationCard::eventFilter(QObject *obj, QEvent *event)
 
 void NotificationCard::onSendButtonClicked()
 {
+    if (!m_replyInput) return;
+    
     QString replyText = m_replyInput->text().trimmed();
     if (!replyText.isEmpty() && !m_currentActionKey.isEmpty()) {
         emit replyRequested(m_currentActionKey, replyText);
         hideInput();
+        emit expandedChanged(isExpanded());
     }
 }
 
 void NotificationCard::onCancelButtonClicked()
 {
     hideInput();
+    emit expandedChanged(isExpanded());
 }
 
 void NotificationCard::onInputReturnPressed()
@@ -507,22 +723,37 @@ void NotificationCard::onActionIndicatorClicked()
         hideActions();
         hideBodies();
         hideInput();
-        if (m_actionIndicator) {
-            m_actionIndicator->setText("⌄"); // Down arrow
-        }
+        emit expandedChanged(false);
     } else {
         // Show expanded content
         showActions();  // This will show actions if they exist
         showBodies();   // This will show all bodies if grouped
-        if (m_actionIndicator) {
-            m_actionIndicator->setText("⌃"); // Up arrow
-        }
+        emit expandedChanged(isExpanded());
     }
 }
 
 void NotificationCard::updateCardHeight()
 {
+    updateActionIndicator();
+    
     // Let Qt handle the height automatically through layout system
     updateGeometry();
     update();
+    emit heightChanged();
+}
+
+void NotificationCard::updateActionIndicator()
+{
+    if (!m_actionIndicator) return;
+    
+    bool expanded = isExpanded();
+    if (m_actionIndicator->property("expanded").toBool() == expanded) {
+        return;
+    }
+    
+    // Up arrow while expanded, down arrow otherwise; the stylesheet keys off the property
+    m_actionIndicator->setText(expanded ? "⌃" : "⌄");
+    m_actionIndicator->setProperty("expanded", expanded);
+    m_actionIndicator->style()->unpolish(m_actionIndicator);
+    m_actionIndicator->style()->polish(m_actionIndicator);
 }
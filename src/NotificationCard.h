@@ -10,6 +10,9 @@
 #include <QEnterEvent>
 #include "NotificationData.h"
 
+class QListView;
+class GroupBodiesModel;
+
 class NotificationCard : public QWidget
 {
     Q_OBJECT
@@ -19,18 +22,28 @@ public:
     ~NotificationCard();
 
     int getNotificationId() const { return m_notificationData.id; }
+    bool isExpanded() const { return m_actionsVisible || m_bodiesExpanded || m_inputVisible; }
     const NotificationData& getNotificationData() const { return m_notificationData; }
     void updateNotificationData(const NotificationData& newData);
+    // Hides actions, extra bodies and the reply input, e.g. before the card is reused
+    void collapse();
 
 signals:
     void removeRequested();
     void actionClicked(const QString& action);
     void replyRequested(const QString& key, const QString& message);
+    // Emitted when the card expands or collapses (actions, all bodies or reply input)
+    void expandedChanged(bool expanded);
+    // Emitted whenever the card's preferred height may have changed
+    void heightChanged();
 
 protected:
     void paintEvent(QPaintEvent *event) override;
     void enterEvent(QEnterEvent *event) override;
     void leaveEvent(QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
     bool eventFilter(QObject *obj, QEvent *event) override;
 
 private slots:
@@ -44,15 +57,25 @@ private slots:
 private:
     void setupUI();
     void updateTimeLabel();
+    void updatePictures();
     void setupActionButtons();
+    void teardownActionButtons();
+    void updateActionButtons();
+    QPushButton* createActionButton(const NotificationAction& action);
     void setupInputField();
+    void teardownInputField();
     void showActions();
     void hideActions();
     void showBodies();
     void hideBodies();
+    void setupBodyList();
+    void teardownBodyList();
+    void updateBodyList();
+    void updateBodyListHeight();
     void showInput(const QString& actionKey);
     void hideInput();
     void updateCardHeight();
+    void updateActionIndicator();
     
     NotificationData m_notificationData;
     
@@ -61,17 +84,24 @@ private:
     QVBoxLayout* m_contentLayout;
     QHBoxLayout* m_actionLayout;
     
+    QLabel* m_iconLabel;   // Only shown when the notification has an icon
     QLabel* m_appNameLabel;
     QLabel* m_timeLabel;
     QLabel* m_titleLabel;
     QLabel* m_bodyLabel;
+    QLabel* m_imageLabel;  // Picture beside the title and body, if any
     QPushButton* m_removeButton;
     QLabel* m_actionIndicator; // Down arrow for actions
-    QWidget* m_actionWidget; // Container for action buttons
+    QWidget* m_actionWidget; // Container for action buttons, only while expanded
     QHBoxLayout* m_actionButtonsLayout;
     QList<QPushButton*> m_actionButtons;
     
-    // Input field for remote_input actions
+    // Every body of an expanded group, newest first, only while expanded
+    QListView* m_bodyList;
+    GroupBodiesModel* m_bodiesModel;
+    QLabel* m_earlierLabel; // Count of bodies no longer kept in the group
+    
+    // Input field for remote_input actions, only while replying
     QWidget* m_inputWidget; // Container for input field and send/cancel buttons
     QVBoxLayout* m_inputLayout;
     QLineEdit* m_replyInput;
@@ -87,6 +117,8 @@ private:
     
     static constexpr int CARD_MARGIN = 12;
     static constexpr int CARD_SPACING = 8;
+    static constexpr int MAX_BODY_LIST_HEIGHT = 240;
+    static constexpr int BODY_LIST_BATCH_SIZE = 20;
 };
 
 #endif // NOTIFICATIONCARD_H
@@ -0,0 +1,89 @@
+#include "NotificationCardPool.h"
+#include "NotificationCard.h"
+#include "Logger.h"
+
+#include <QWidget>
+
+NotificationCardPool::NotificationCardPool(QWidget* parentWidget, QObject *parent)
+    : QObject(parent)
+    , m_parentWidget(parentWidget)
+    , m_warmUpTimer(nullptr)
+{
+    // A zero-interval timer only fires once pending events are processed,
+    // so cards are built while the event loop is otherwise idle
+    m_warmUpTimer = new QTimer(this);
+    m_warmUpTimer->setSingleShot(true);
+    m_warmUpTimer->setInterval(0);
+    connect(m_warmUpTimer, &QTimer::timeout, this, &NotificationCardPool::warmUp);
+    
+    scheduleWarmUp();
+}
+
+NotificationCardPool::~NotificationCardPool()
+{
+    // Pooled cards are children of the parent widget and go away with it
+}
+
+NotificationCard* NotificationCardPool::acquire(const NotificationData& notification)
+{
+    NotificationCard* card = nullptr;
+    if (!m_cards.isEmpty()) {
+        card = m_cards.takeLast();
+        card->updateNotificationData(notification);
+    } else {
+        card = new NotificationCard(notification, m_parentWidget);
+        Logger::debug("Card pool empty, built a new NotificationCard");
+    }
+    
+    scheduleWarmUp();
+    return card;
+}
+
+void NotificationCardPool::release(NotificationCard* card)
+{
+    if (!card) {
+        return;
+    }
+    
+    // Drop the previous owner's connections so a rebound card starts clean
+    card->disconnect();
+    card->hide();
+    card->collapse();
+    
+    if (m_cards.size() >= MAX_POOLED || card->parentWidget() != m_parentWidget) {
+        card->deleteLater();
+        return;
+    }
+    m_cards.append(card);
+}
+
+void NotificationCardPool::trim()
+{
+    // The next acquire() builds a card and restarts the warm-up
+    m_warmUpTimer->stop();
+    for (NotificationCard* card : std::as_const(m_cards)) {
+        card->deleteLater();
+    }
+    m_cards.clear();
+}
+
+void NotificationCardPool::scheduleWarmUp()
+{
+    if (m_cards.size() < PREWARM_COUNT && m_parentWidget && !m_warmUpTimer->isActive()) {
+        m_warmUpTimer->start();
+    }
+}
+
+void NotificationCardPool::warmUp()
+{
+    if (!m_parentWidget || m_cards.size() >= PREWARM_COUNT) {
+        return;
+    }
+    
+    // One card per pass keeps each idle slice short
+    NotificationCard* card = new NotificationCard(NotificationData(), m_parentWidget);
+    card->hide();
+    m_cards.append(card);
+    
+    scheduleWarmUp();
+}
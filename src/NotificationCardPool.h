@@ -0,0 +1,49 @@
+#ifndef NOTIFICATIONCARDPOOL_H
+#define NOTIFICATIONCARDPOOL_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include "NotificationData.h"
+
+class NotificationCard;
+class QWidget;
+
+// Keeps pre-built NotificationCards around so showing a card costs a rebind
+// instead of building a widget tree, stylesheets and layouts from scratch.
+// Cards are all children of one parent widget (the list viewport).
+class NotificationCardPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NotificationCardPool(QWidget* parentWidget, QObject *parent = nullptr);
+    ~NotificationCardPool();
+
+    // Returns a card bound to the notification, reusing a pooled one when possible
+    NotificationCard* acquire(const NotificationData& notification);
+    // Collapses and hides the card and keeps it for the next acquire()
+    void release(NotificationCard* card);
+    
+    // Deletes every pooled card, e.g. while the panel is hidden
+    void trim();
+    
+    QWidget* parentWidget() const { return m_parentWidget; }
+    int pooledCount() const { return m_cards.size(); }
+    
+    static constexpr int PREWARM_COUNT = 3;  // Cards built ahead of time at idle
+    static constexpr int MAX_POOLED = 8;     // Released cards beyond this are deleted
+
+private slots:
+    void warmUp();
+
+private:
+    void scheduleWarmUp();
+    
+    QPointer<QWidget> m_parentWidget;
+    QList<NotificationCard*> m_cards;
+    QTimer* m_warmUpTimer;
+};
+
+#endif // NOTIFICATIONCARDPOOL_H
@@ -1,10 +1,12 @@
 #include "NotificationClient.h"
 #include "Logger.h"
+#include "BlobCache.h"
 #include "qglobal.h"
 #include <QDebug>
 #include <QJsonParseError>
 #include <QJsonArray>
 #include <QUuid>
+#include <QCryptographicHash>
 #include <QSysInfo>
 
 NotificationClient::NotificationClient(QObject *parent)
@@ -16,6 +18,8 @@ NotificationClient::NotificationClient(QObject *parent)
     , m_isConnected(false)
     , m_autoReconnect(true)
     , m_handshakeComplete(false)
+    , m_peerSupportsBlobs(false)
+    , m_blobExpiryTimer(new QTimer(this))
 {
     // Connect service discovery signals
     connect(m_serviceDiscovery, &ServiceDiscovery::serviceFound,
@@ -29,6 +33,10 @@ NotificationClient::NotificationClient(QObject *parent)
     connect(m_reconnectTimer, &QTimer::timeout,
             this, &NotificationClient::onReconnectTimer);
     
+    // Runs only while transfers are in flight
+    m_blobExpiryTimer->setInterval(BLOB_TIMEOUT);
+    connect(m_blobExpiryTimer, &QTimer::timeout, this, &NotificationClient::expireBlobTransfers);
+    
     setupSocket();
 }
 
@@ -100,7 +108,10 @@ void NotificationClient::disconnectFromServer()
     }
     
     m_isConnected = false;
+    m_peerSupportsBlobs = false;
     m_receiveBuffer.clear();
+    m_blobTransfers.clear();
+    m_blobExpiryTimer->stop();
 }
 
 bool NotificationClient::isConnected() const
@@ -159,7 +170,10 @@ void NotificationClient::onSocketDisconnected()
 {
     m_isConnected = false;
     m_handshakeComplete = false;
+    m_peerSupportsBlobs = false;
     m_receiveBuffer.clear();
+    m_blobTransfers.clear();  // Requested again when a notification next refers to them
+    m_blobExpiryTimer->stop();
     
     Logger::info("Disconnected from server");
     emit disconnected();
@@ -228,7 +242,10 @@ void NotificationClient::processReceivedData()
         }
         
         QJsonObject messageJson = doc.object();
-        Logger::debug(QString("Received message: %1").arg(QJsonDocument(messageJson).toJson(QJsonDocument::Compact)));
+        // Blob chunks are mostly base64 and not worth logging
+        if (messageJson.value("type").toString() != "blob_chunk") {
+            Logger::debug(QString("Received message: %1").arg(QJsonDocument(messageJson).toJson(QJsonDocument::Compact)));
+        }
         
         // Handle the message
         handleMessage(messageJson);
@@ -248,6 +265,19 @@ NotificationData NotificationClient::parseNotificationJson(const QJsonObject& js
     notification.packageName = json.value("package").toString();
     notification.canReply = json.value("can_reply").toBool();
     
+    // Pictures are sent by content hash; only unknown ones are fetched
+    QString iconHash = json.value("icon").toString();
+    if (BlobCache::isValidHash(iconHash)) {
+        notification.iconHash = iconHash;
+        notification.iconPath = BlobCache::instance()->pathFor(iconHash);
+        requestBlob(iconHash);
+    }
+    QString imageHash = json.value("image").toString();
+    if (BlobCache::isValidHash(imageHash)) {
+        notification.imageHash = imageHash;
+        requestBlob(imageHash);
+    }
+    
     // Initialize bodies array with the primary body
     if (!notification.body.isEmpty()) {
         notification.bodies.append(notification.body);
@@ -297,6 +327,7 @@ void NotificationClient::sendConnectionRequest()
     supports.append("notification");
     supports.append("ping");
     supports.append("pong");
+    supports.append("blob");
     payload["supports"] = supports;
     payload["auth_token"] = "relay-pc-token";
     
@@ -340,6 +371,8 @@ void NotificationClient::handleMessage(const QJsonObject& message)
         
         if (status == "ok") {
             m_handshakeComplete = true;
+            // Phone apps without blob support never answer a blob_request
+            m_peerSupportsBlobs = payload.value("supports").toArray().contains(QJsonValue("blob"));
             Logger::info("Handshake successful - ready to receive notifications");
             emit connected();
         } else {
@@ -364,6 +397,11 @@ void NotificationClient::handleMessage(const QJsonObject& message)
             handleNotificationAction(message);
         }
     }
+    else if (msgType == "blob_chunk") {
+        if (m_handshakeComplete) {
+            handleBlobChunk(message);
+        }
+    }
     else if (msgType == "ping") {
         Logger::debug(QString("Received ping with ID: %1").arg(message.value("id").toString()));
         handlePing(message);
@@ -395,6 +433,96 @@ void NotificationClient::handleNotificationAction(const QJsonObject& message)
     }
 }
 
+void NotificationClient::requestBlob(const QString& hash)
+{
+    // Known blobs cost nothing on the wire; one request per transfer in flight
+    if (!m_peerSupportsBlobs) {
+        return;
+    }
+    expireBlobTransfers();
+    if (BlobCache::instance()->contains(hash) || m_blobTransfers.contains(hash)) {
+        return;
+    }
+    m_blobTransfers.insert(hash, BlobTransfer{QByteArray(), -1, QDateTime::currentMSecsSinceEpoch()});
+    if (!m_blobExpiryTimer->isActive()) {
+        m_blobExpiryTimer->start();
+    }
+    
+    QJsonObject requestMsg;
+    requestMsg["type"] = "blob_request";
+    requestMsg["id"] = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    requestMsg["timestamp"] = QDateTime::currentSecsSinceEpoch();
+    
+    QJsonObject payload;
+    payload["hash"] = hash;
+    requestMsg["payload"] = payload;
+    
+    Logger::debug(QString("Requesting blob %1").arg(hash));
+    sendMessage(requestMsg);
+}
+
+void NotificationClient::expireBlobTransfers()
+{
+    // The phone may drop a request (e.g. the picture is gone); forget it so
+    // the next notification referring to the hash requests it again
+    qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - BLOB_TIMEOUT;
+    for (auto it = m_blobTransfers.begin(); it != m_blobTransfers.end();) {
+        if (it->lastActivity < cutoff) {
+            Logger::debug(QString("Blob %1 timed out").arg(it.key()));
+            it = m_blobTransfers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (m_blobTransfers.isEmpty()) {
+        m_blobExpiryTimer->stop();
+    }
+}
+
+void NotificationClient::handleBlobChunk(const QJsonObject& message)
+{
+    QJsonObject payload = message.value("payload").toObject();
+    QString hash = payload.value("hash").toString();
+    qint64 offset = payload.value("offset").toInteger(-1);
+    qint64 total = payload.value("total").toInteger(-1);
+    
+    auto it = m_blobTransfers.find(hash);
+    if (it == m_blobTransfers.end()) {
+        Logger::warning(QString("Ignoring chunk of unrequested blob %1").arg(hash));
+        return;
+    }
+    
+    // Chunks arrive in order over the one connection; anything else ends the transfer
+    BlobTransfer& transfer = it.value();
+    QByteArray chunk = QByteArray::fromBase64(payload.value("data").toString().toLatin1());
+    if (total <= 0 || total > MAX_BLOB_BYTES || (transfer.total >= 0 && total != transfer.total)
+        || offset != transfer.data.size() || offset + chunk.size() > total) {
+        Logger::warning(QString("Dropping blob %1: unexpected chunk at %2 of %3").arg(hash).arg(offset).arg(total));
+        m_blobTransfers.erase(it);
+        return;
+    }
+    if (transfer.total < 0) {
+        transfer.total = total;
+        transfer.data.reserve(total);
+    }
+    transfer.data.append(chunk);
+    transfer.lastActivity = QDateTime::currentMSecsSinceEpoch();
+    
+    if (transfer.data.size() < transfer.total) {
+        return;
+    }
+    
+    QByteArray data = transfer.data;
+    m_blobTransfers.erase(it);
+    if (QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex() != hash.toLatin1()) {
+        Logger::warning(QString("Dropping blob %1: content does not match its hash").arg(hash));
+        return;
+    }
+    
+    Logger::debug(QString("Received blob %1 (%2 bytes)").arg(hash).arg(data.size()));
+    BlobCache::instance()->store(hash, data);
+}
+
 void NotificationClient::sendPong(const QString& pingId)
 {
     QJsonObject pongMsg;
@@ -7,6 +7,7 @@
 #include <QHostAddress>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QHash>
 #include "NotificationData.h"
 #include "ServiceDiscovery.h"
 
@@ -59,6 +60,9 @@ private:
     void handleMessage(const QJsonObject& message);
     void handlePing(const QJsonObject& message);
     void handleNotificationAction(const QJsonObject& message);
+    void handleBlobChunk(const QJsonObject& message);
+    void requestBlob(const QString& hash);
+    void expireBlobTransfers();
     void sendPong(const QString& pingId);
     NotificationData parseNotificationJson(const QJsonObject& json);
     void startReconnectTimer();
@@ -75,9 +79,22 @@ private:
     bool m_isConnected;
     bool m_autoReconnect;
     bool m_handshakeComplete;
+    bool m_peerSupportsBlobs;  // The ack listed "blob" in its supports
+    
+    // Icons and images being received in blob_chunk frames, by hash
+    struct BlobTransfer {
+        QByteArray data;
+        qint64 total;
+        qint64 lastActivity;  // Request or last chunk, ms since epoch
+    };
+    QHash<QString, BlobTransfer> m_blobTransfers;
+    QTimer* m_blobExpiryTimer;
     
     static constexpr int RECONNECT_INTERVAL = 5000; // 5 seconds
     static constexpr quint16 DEFAULT_PORT = 9999;
+    static constexpr qint64 MAX_BLOB_BYTES = 4 * 1024 * 1024;
+    // A transfer without a chunk for this long is dropped and may be requested again
+    static constexpr int BLOB_TIMEOUT = 30000;
 };
 
 #endif // NOTIFICATIONCLIENT_H
@@ -28,9 +28,12 @@ QJsonObject NotificationData::toJson() const
     json["title"] = title;
     json["body"] = body;
     json["iconPath"] = iconPath;
+    json["iconHash"] = iconHash;
+    json["imageHash"] = imageHash;
     json["packageName"] = packageName;
     json["timestamp"] = timestamp.toString(Qt::ISODate);
     json["id"] = id;
+    json["stringId"] = stringId;
     json["canReply"] = canReply;
     json["groupCount"] = groupCount;
     
@@ -57,9 +60,12 @@ NotificationData NotificationData::fromJson(const QJsonObject& json)
     notification.title = json["title"].toString();
     notification.body = json["body"].toString();
     notification.iconPath = json["iconPath"].toString();
+    notification.iconHash = json["iconHash"].toString();
+    notification.imageHash = json["imageHash"].toString();
     notification.packageName = json["packageName"].toString();
     notification.timestamp = QDateTime::fromString(json["timestamp"].toString(), Qt::ISODate);
     notification.id = json["id"].toInt();
+    notification.stringId = json["stringId"].toString();
     notification.canReply = json["canReply"].toBool();
     notification.groupCount = json["groupCount"].toInt(1);  // Default to 1 if not present
     
@@ -87,11 +93,38 @@ QString NotificationData::getGroupKey() const
     return QString("%1|%2").arg(appName, title);
 }
 
+void NotificationData::syncLookups()
+{
+    // Sizes cannot tell: bodies and actions from the phone may repeat
+    if (lookupsSynced) {
+        return;
+    }
+    
+    bodySet = QSet<QString>(bodies.cbegin(), bodies.cend());
+    actionKeys.clear();
+    for (const NotificationAction& action : actions) {
+        actionKeys.insert(action.key);
+    }
+    lookupsSynced = true;
+}
+
 void NotificationData::mergeWith(const NotificationData& other)
 {
-    // Add the new notification's body to our bodies list
-    if (!other.body.isEmpty() && !bodies.contains(other.body)) {
-        bodies.append(other.body);
+    syncLookups();
+    
+    // Add the other side's bodies to our ring, oldest first; other may
+    // itself be a merged group (a popup batch), not just a single message
+    const QStringList otherBodies = other.bodies.isEmpty() ? QStringList{other.body} : other.bodies;
+    for (const QString& bodyText : otherBodies) {
+        if (!bodyText.isEmpty() && !bodySet.contains(bodyText)) {
+            bodies.append(bodyText);
+            bodySet.insert(bodyText);
+        }
+    }
+    
+    // Drop the oldest bodies once the ring is full; groupCount keeps the total
+    while (bodies.size() > MAX_GROUP_BODIES) {
+        bodySet.remove(bodies.takeFirst());
     }
     
     // Update to the latest timestamp
@@ -104,20 +137,22 @@ void NotificationData::mergeWith(const NotificationData& other)
         body = other.body;
     }
     
-    // Increment group count
-    groupCount++;
+    // Pictures follow the latest message too, e.g. the sender of a group chat message
+    if (!other.iconHash.isEmpty()) {
+        iconHash = other.iconHash;
+        iconPath = other.iconPath;
+    }
+    if (!other.imageHash.isEmpty()) {
+        imageHash = other.imageHash;
+    }
+    
+    groupCount += other.groupCount;
     
     // Merge actions (avoid duplicates)
     for (const NotificationAction& action : other.actions) {
-        bool exists = false;
-        for (const NotificationAction& existingAction : actions) {
-            if (existingAction.key == action.key) {
-                exists = true;
-                break;
-            }
-        }
-        if (!exists) {
+        if (!actionKeys.contains(action.key)) {
             actions.append(action);
+            actionKeys.insert(action.key);
         }
     }
     
@@ -150,3 +185,26 @@ QString NotificationData::getAllBodiesFormatted() const
     
     return result;
 }
+
+qint64 NotificationData::memoryFootprint() const
+{
+    qint64 bytes = sizeof(NotificationData);
+    bytes += (appName.size() + title.size() + iconPath.size() + iconHash.size()
+              + imageHash.size() + packageName.size() + stringId.size()) * sizeof(QChar);
+    
+    // The primary body is normally one of the bodies and shares its text,
+    // as do the lookup set's entries, so each text is counted once
+    if (!bodies.contains(body)) {
+        bytes += body.size() * sizeof(QChar);
+    }
+    for (const QString& bodyText : bodies) {
+        bytes += sizeof(QString) + bodyText.size() * sizeof(QChar);
+    }
+    bytes += bodySet.size() * sizeof(QString);
+    for (const NotificationAction& action : actions) {
+        bytes += sizeof(NotificationAction)
+                 + (action.title.size() + action.type.size() + 2 * action.key.size()) * sizeof(QChar);
+    }
+    
+    return bytes;
+}
@@ -5,6 +5,8 @@
 #include <QDateTime>
 #include <QJsonObject>
 #include <QList>
+#include <QSet>
+#include <QStringList>
 
 struct NotificationAction {
     QString title;
@@ -23,34 +25,55 @@ struct NotificationData {
     QString appName;
     QString title;
     QString body;  // Primary body text (for backward compatibility)
-    QStringList bodies;  // Array of all bodies for grouped notifications
-    QString iconPath;
+    QStringList bodies;  // Most recent bodies for grouped notifications, oldest first (capped)
+    QString iconPath;   // Local copy of the app or contact icon, in the blob cache
+    QString iconHash;   // SHA-256 of the icon, as sent by the phone
+    QString imageHash;  // SHA-256 of a larger picture shown beside the text
     QString packageName;
     int id;
     QString stringId;  // Original string ID from protocol
     QDateTime timestamp;
     bool canReply;
     QList<NotificationAction> actions;
-    int groupCount;  // Number of notifications in this group
+    int groupCount;  // Number of notifications in this group (not capped like bodies)
     
-    NotificationData() : id(0), timestamp(QDateTime::currentDateTime()), canReply(false), groupCount(1) {}
+    // Hashed lookups backing mergeWith(). Only mergeWith() keeps them in
+    // sync; code that edits bodies or actions directly clears lookupsSynced
+    QSet<QString> bodySet;
+    QSet<QString> actionKeys;
+    bool lookupsSynced;
+    
+    // Maximum number of bodies kept in memory for a group
+    static constexpr int MAX_GROUP_BODIES = 50;
+    
+    NotificationData() : id(0), timestamp(QDateTime::currentDateTime()), canReply(false), groupCount(1),
+                         lookupsSynced(false) {}
     
     NotificationData(const QString& app, const QString& title, const QString& body)
         : appName(app), title(title), body(body), id(0), 
-          timestamp(QDateTime::currentDateTime()), canReply(false), groupCount(1) {
+          timestamp(QDateTime::currentDateTime()), canReply(false), groupCount(1), lookupsSynced(false) {
         bodies.append(body);
     }
     
     // Helper methods for grouping
     QString getGroupKey() const;
+    // Merges a single message or a whole group into this one. Bodies pushed
+    // out of the ring stay readable in the history, which stores every
+    // notification as it arrives
     void mergeWith(const NotificationData& other);
     QString getDisplayBody() const;
     QString getAllBodiesFormatted() const;
     bool isGrouped() const { return groupCount > 1; }
     
+    // Approximate heap usage, used for memory-based retention
+    qint64 memoryFootprint() const;
+    
     // Convert to/from JSON for serialization
     QJsonObject toJson() const;
     static NotificationData fromJson(const QJsonObject& json);
+
+private:
+    void syncLookups();
 };
 
 #endif // NOTIFICATIONDATA_H
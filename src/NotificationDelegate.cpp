@@ -0,0 +1,296 @@
+#include "NotificationDelegate.h"
+#include "BackgroundCache.h"
+#include "BlobCache.h"
+#include "NotificationCard.h"
+#include "CardRenderer.h"
+#include "NotificationCardPool.h"
+#include "NotificationListModel.h"
+#include "RelativeTimeTicker.h"
+#include "TextLayoutCache.h"
+
+#include <QAbstractItemView>
+#include <QPainter>
+#include <QFontMetrics>
+
+namespace {
+
+const NotificationData* notificationFor(const QModelIndex& index)
+{
+    auto model = qobject_cast<const NotificationListModel*>(index.model());
+    if (!model || !index.isValid()) {
+        return nullptr;
+    }
+    return &model->notificationAt(index.row());
+}
+
+QFont cardFont(const QFont& base, int pixelSize, bool bold)
+{
+    QFont font(base);
+    font.setPixelSize(pixelSize);
+    font.setBold(bold);
+    return font;
+}
+
+} // namespace
+
+NotificationDelegate::NotificationDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+    , m_cardPool(nullptr)
+    , m_renderer(nullptr)
+{
+    m_renderer = new CardRenderer(this);
+    connect(m_renderer, &CardRenderer::imageReady, this, [this](const QPersistentModelIndex& index) {
+        emit contentReady(index);
+    });
+    
+    // Editors are parented to the view's viewport, so that is where pooled cards live
+    if (auto view = qobject_cast<QAbstractItemView*>(parent)) {
+        m_cardPool = new NotificationCardPool(view->viewport(), this);
+    }
+}
+
+NotificationDelegate::~NotificationDelegate()
+{
+}
+
+int NotificationDelegate::rowWidth(const QStyleOptionViewItem& option) const
+{
+    // QListView asks for size hints without an item rect, so fall back to the viewport
+    if (option.rect.width() > 0) {
+        return option.rect.width();
+    }
+    if (auto view = qobject_cast<const QAbstractItemView*>(option.widget)) {
+        return view->viewport()->width();
+    }
+    return 0;
+}
+
+CardRenderer::Content NotificationDelegate::contentFor(const NotificationData& notification,
+                                                       const QStyleOptionViewItem& option,
+                                                       const QSize& size, qreal devicePixelRatio) const
+{
+    CardRenderer::Content content;
+    content.id = notification.id;
+    content.appName = notification.appName;
+    content.time = RelativeTimeTicker::instance()->format(notification.timestamp);
+    content.title = notification.title;
+    content.body = notification.body.isEmpty() ? QString() : notification.getDisplayBody();
+    content.indicator = !notification.actions.isEmpty() || notification.isGrouped();
+    // Pictures decode off-thread; the row is repainted when they are ready
+    content.hasIcon = !notification.iconHash.isEmpty();
+    content.hasImage = !notification.imageHash.isEmpty();
+    BlobCache* blobs = BlobCache::instance();
+    content.icon = blobs->image(notification.iconHash,
+                                QSize(CardRenderer::ICON_SIZE, CardRenderer::ICON_SIZE), devicePixelRatio);
+    content.image = blobs->image(notification.imageHash,
+                                 QSize(CardRenderer::IMAGE_SIZE, CardRenderer::IMAGE_SIZE), devicePixelRatio);
+    content.appFont = cardFont(option.font, 12, true);
+    content.indicatorFont = cardFont(option.font, 14, true);
+    content.removeFont = cardFont(option.font, 16, true);
+    content.timeFont = cardFont(option.font, 10, false);
+    content.titleFont = cardFont(option.font, 14, true);
+    content.bodyFont = cardFont(option.font, 12, false);
+    content.size = size;
+    content.devicePixelRatio = devicePixelRatio;
+    return content;
+}
+
+void NotificationDelegate::paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    const NotificationData* notification = notificationFor(index);
+    if (!notification || editorFor(index)) {
+        // Rows with an open editor are drawn by the NotificationCard itself
+        return;
+    }
+    
+    // Same look as NotificationCard::paintEvent(); the background depends on
+    // hover state and comes from the nine-patch cache
+    QRect cardRect = option.rect.adjusted(0, 0, -SCROLLBAR_GAP, -ROW_SPACING);
+    bool hovered = option.state & QStyle::State_MouseOver;
+    BackgroundCache::draw(painter, cardRect, BackgroundCache::cardStyle(hovered));
+    
+    QRect contentRect = cardRect.adjusted(CARD_MARGIN, CARD_MARGIN, -CARD_MARGIN, -CARD_MARGIN);
+    qreal dpr = painter->device() ? painter->device()->devicePixelRatio() : 1.0;
+    CardRenderer::Content content = contentFor(*notification, option, contentRect.size(), dpr);
+    
+    // Text is rasterized off the GUI thread; until that lands, paint it directly
+    QImage image = m_renderer->image(content, index);
+    painter->save();
+    painter->translate(contentRect.topLeft());
+    painter->setClipRect(QRect(QPoint(0, 0), contentRect.size()));
+    if (!image.isNull()) {
+        painter->drawImage(QPoint(0, 0), image);
+        CardRenderer::paintTime(painter, content);
+    } else {
+        CardRenderer::paintContent(painter, content);
+    }
+    painter->restore();
+}
+
+QSize NotificationDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    const NotificationData* notification = notificationFor(index);
+    int width = rowWidth(option);
+    if (!notification || width <= 0) {
+        return QStyledItemDelegate::sizeHint(option, index);
+    }
+    
+    int cardWidth = width - SCROLLBAR_GAP;
+    
+    // Interactive rows take whatever height their card currently needs
+    if (NotificationCard* card = editorFor(index)) {
+        int height = card->hasHeightForWidth() ? card->heightForWidth(cardWidth) : card->sizeHint().height();
+        return QSize(width, height + ROW_SPACING);
+    }
+    
+    int contentWidth = cardWidth - 2 * CARD_MARGIN;
+    bool hasImage = !notification->imageHash.isEmpty();
+    int textWidth = CardRenderer::textWidth(contentWidth, hasImage);
+    int height = 2 * CARD_MARGIN + HEADER_HEIGHT;
+    int contentHeight = 0;
+    
+    // Cached layouts, so relayouts measure each text once per width
+    TextLayoutCache& textCache = TextLayoutCache::instance();
+    if (!notification->title.isEmpty()) {
+        contentHeight += textCache.height(notification->title, cardFont(option.font, 14, true), textWidth);
+    }
+    if (!notification->body.isEmpty()) {
+        if (contentHeight > 0) {
+            contentHeight += CONTENT_SPACING;
+        }
+        contentHeight += textCache.height(notification->getDisplayBody(), cardFont(option.font, 12, false), textWidth);
+    }
+    if (hasImage) {
+        contentHeight = qMax(contentHeight, CardRenderer::IMAGE_SIZE);
+    }
+    if (contentHeight > 0) {
+        height += CARD_SPACING + contentHeight;
+    }
+    
+    // Rows near the top are what the panel shows when it opens or after a
+    // resize, so start rasterizing them as soon as they are measured
+    if (index.row() < PRERENDER_ROWS) {
+        const QWidget* widget = option.widget;
+        qreal dpr = widget ? widget->devicePixelRatioF() : 1.0;
+        m_renderer->image(contentFor(*notification, option, QSize(contentWidth, height - 2 * CARD_MARGIN), dpr), index);
+    }
+    
+    return QSize(width, height + ROW_SPACING);
+}
+
+QWidget* NotificationDelegate::createEditor(QWidget* parent, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    Q_UNUSED(option)
+    
+    const NotificationData* notification = notificationFor(index);
+    if (!notification) {
+        return nullptr;
+    }
+    
+    NotificationCard* card = nullptr;
+    if (m_cardPool && parent == m_cardPool->parentWidget()) {
+        card = m_cardPool->acquire(*notification);
+    } else {
+        card = new NotificationCard(*notification, parent);
+    }
+    QPersistentModelIndex persistent(index);
+    auto self = const_cast<NotificationDelegate*>(this);
+    
+    connect(card, &NotificationCard::removeRequested, self, [self, persistent]() {
+        if (persistent.isValid()) {
+            emit self->removeRequested(persistent);
+        }
+    });
+    connect(card, &NotificationCard::actionClicked, self, [self, persistent](const QString& actionKey) {
+        if (persistent.isValid()) {
+            emit self->actionClicked(persistent, actionKey);
+        }
+    });
+    connect(card, &NotificationCard::replyRequested, self, [self, persistent](const QString& actionKey, const QString& replyText) {
+        if (persistent.isValid()) {
+            emit self->replyRequested(persistent, actionKey, replyText);
+        }
+    });
+    connect(card, &NotificationCard::expandedChanged, self, [self, persistent](bool expanded) {
+        if (persistent.isValid()) {
+            emit self->expandedChanged(persistent, expanded);
+        }
+    });
+    // Expanding actions or bodies changes the row height
+    connect(card, &NotificationCard::heightChanged, self, [self, persistent]() {
+        if (persistent.isValid()) {
+            emit self->sizeHintChanged(persistent);
+        }
+    });
+    
+    // No sizeHintChanged() here: a card at rest matches its painted row, so
+    // hovering swaps one row's pixels without relaying out the list
+    m_editors.append({persistent, card});
+    return card;
+}
+
+void NotificationDelegate::setEditorData(QWidget* editor, const QModelIndex& index) const
+{
+    NotificationCard* card = qobject_cast<NotificationCard*>(editor);
+    const NotificationData* notification = notificationFor(index);
+    if (!card || !notification) {
+        return;
+    }
+    
+    // Called right after createEditor() and on every dataChanged(); only
+    // rebuild the card when the group actually changed
+    const NotificationData& current = card->getNotificationData();
+    if (current.id == notification->id && current.groupCount == notification->groupCount
+        && current.timestamp == notification->timestamp) {
+        return;
+    }
+    card->updateNotificationData(*notification);
+}
+
+void NotificationDelegate::updateEditorGeometry(QWidget* editor, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    Q_UNUSED(index)
+    editor->setGeometry(option.rect.adjusted(0, 0, -SCROLLBAR_GAP, -ROW_SPACING));
+}
+
+void NotificationDelegate::destroyEditor(QWidget* editor, const QModelIndex& index) const
+{
+    for (int i = 0; i < m_editors.size(); ++i) {
+        if (m_editors[i].card == editor) {
+            m_editors.removeAt(i);
+            break;
+        }
+    }
+    
+    NotificationCard* card = qobject_cast<NotificationCard*>(editor);
+    if (card && m_cardPool) {
+        m_cardPool->release(card);
+    } else {
+        QStyledItemDelegate::destroyEditor(editor, index);
+    }
+}
+
+bool NotificationDelegate::isExpanded(const QModelIndex& index) const
+{
+    NotificationCard* card = editorFor(index);
+    return card && card->isExpanded();
+}
+
+void NotificationDelegate::releaseResources()
+{
+    if (m_cardPool) {
+        m_cardPool->trim();
+    }
+    m_renderer->clear();
+}
+
+NotificationCard* NotificationDelegate::editorFor(const QModelIndex& index) const
+{
+    // Only the hovered and expanded rows have editors, so a linear scan is enough
+    for (const EditorEntry& entry : m_editors) {
+        if (entry.index == index) {
+            return entry.card;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,69 @@
+#ifndef NOTIFICATIONDELEGATE_H
+#define NOTIFICATIONDELEGATE_H
+
+#include <QStyledItemDelegate>
+#include <QPersistentModelIndex>
+#include <QPointer>
+#include <QList>
+#include "NotificationData.h"
+#include "CardRenderer.h"
+
+class NotificationCard;
+class NotificationCardPool;
+
+// Paints notification rows the way NotificationCard looks at rest, so the
+// list only needs real widgets for rows the user interacts with. Those rows
+// get a NotificationCard as their editor.
+class NotificationDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit NotificationDelegate(QObject *parent = nullptr);
+    ~NotificationDelegate();
+
+    void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    
+    QWidget* createEditor(QWidget* parent, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    void setEditorData(QWidget* editor, const QModelIndex& index) const override;
+    void updateEditorGeometry(QWidget* editor, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    void destroyEditor(QWidget* editor, const QModelIndex& index) const override;
+    
+    bool isExpanded(const QModelIndex& index) const;
+    // Frees pooled cards and rasterized content; both are rebuilt on demand
+    void releaseResources();
+    
+    static constexpr int CARD_MARGIN = 12;
+    static constexpr int CARD_SPACING = 8;
+    static constexpr int CONTENT_SPACING = 4;
+    static constexpr int HEADER_HEIGHT = 20;
+    static constexpr int ROW_SPACING = 8;    // Gap below each card
+    static constexpr int SCROLLBAR_GAP = 6;  // Room on the right for the scroll bar
+    static constexpr int PRERENDER_ROWS = 30; // Rows rasterized ahead of their first paint
+
+signals:
+    void removeRequested(const QModelIndex& index);
+    void actionClicked(const QModelIndex& index, const QString& actionKey);
+    void replyRequested(const QModelIndex& index, const QString& actionKey, const QString& replyText);
+    void expandedChanged(const QModelIndex& index, bool expanded);
+    // The row's content finished rasterizing and can be repainted as a blit
+    void contentReady(const QModelIndex& index);
+
+private:
+    struct EditorEntry {
+        QPersistentModelIndex index;
+        QPointer<NotificationCard> card;
+    };
+    
+    NotificationCard* editorFor(const QModelIndex& index) const;
+    int rowWidth(const QStyleOptionViewItem& option) const;
+    CardRenderer::Content contentFor(const NotificationData& notification, const QStyleOptionViewItem& option,
+                                     const QSize& size, qreal devicePixelRatio) const;
+    
+    mutable QList<EditorEntry> m_editors;
+    NotificationCardPool* m_cardPool;  // Editors are recycled rather than rebuilt
+    CardRenderer* m_renderer;          // Off-thread rasterized row content
+};
+
+#endif // NOTIFICATIONDELEGATE_H
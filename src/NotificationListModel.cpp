@@ -0,0 +1,167 @@
+#include "NotificationListModel.h"
+
+NotificationListModel::NotificationListModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_liveCount(0)
+{
+}
+
+NotificationListModel::~NotificationListModel()
+{
+}
+
+int NotificationListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant NotificationListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+
+    const Row& row = m_rows[index.row()];
+    switch (role) {
+    case Qt::DisplayRole:
+        return row.data.title;
+    case Qt::ToolTipRole:
+        return row.data.getDisplayBody();
+    case NotificationIdRole:
+        return row.data.id;
+    case ArchivedRole:
+        return row.archived;
+    default:
+        return QVariant();
+    }
+}
+
+int NotificationListModel::rowForId(int notificationId) const
+{
+    auto it = m_liveIndex.constFind(notificationId);
+    return it != m_liveIndex.constEnd() ? m_liveCount - 1 - it.value() : -1;
+}
+
+void NotificationListModel::shiftLiveIndex(int end, int delta)
+{
+    // Only the rows above a changed row move, and those are the newest few
+    for (int row = 0; row < end; ++row) {
+        m_liveIndex[m_rows[row].data.id] += delta;
+    }
+}
+
+void NotificationListModel::upsertLive(const NotificationData& notification)
+{
+    int row = rowForId(notification.id);
+    if (row < 0) {
+        beginInsertRows(QModelIndex(), 0, 0);
+        m_rows.prepend({notification, false, -1});
+        m_liveIndex.insert(notification.id, m_liveCount);
+        m_liveCount++;
+        endInsertRows();
+        return;
+    }
+
+    // Update in place, then move to the top as a single model move
+    m_rows[row].data = notification;
+    QModelIndex changed = index(row);
+    emit dataChanged(changed, changed);
+
+    if (row > 0) {
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(), 0);
+        shiftLiveIndex(row, -1);
+        m_liveIndex.insert(notification.id, m_liveCount - 1);
+        m_rows.move(row, 0);
+        endMoveRows();
+    }
+}
+
+void NotificationListModel::removeLive(int notificationId)
+{
+    int row = rowForId(notificationId);
+    if (row >= 0) {
+        removeAt(row);
+    }
+}
+
+void NotificationListModel::clearLive()
+{
+    if (m_liveCount == 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), 0, m_liveCount - 1);
+    m_rows.remove(0, m_liveCount);
+    m_liveCount = 0;
+    m_liveIndex.clear();
+    endRemoveRows();
+}
+
+void NotificationListModel::resetLive(const QList<NotificationData>& notifications)
+{
+    // One reset instead of a move per row; the view lays out lazily afterwards
+    beginResetModel();
+    m_rows.clear();
+    m_rows.reserve(notifications.size());
+    m_liveIndex.clear();
+    m_liveIndex.reserve(notifications.size());
+    for (const NotificationData& notification : notifications) {
+        m_liveIndex.insert(notification.id, notifications.size() - 1 - m_rows.size());
+        m_rows.append({notification, false, -1});
+    }
+    m_liveCount = m_rows.size();
+    endResetModel();
+}
+
+void NotificationListModel::insertArchived(int position, const QList<HistoryRecord>& records)
+{
+    if (records.isEmpty()) {
+        return;
+    }
+
+    int first = m_liveCount + qBound(0, position, archivedCount());
+    beginInsertRows(QModelIndex(), first, first + records.size() - 1);
+    int row = first;
+    for (const HistoryRecord& record : records) {
+        m_rows.insert(row++, {record.notification, true, record.seq});
+    }
+    endInsertRows();
+}
+
+void NotificationListModel::removeArchived(int position, int count)
+{
+    int first = m_liveCount + position;
+    int last = qMin(first + count, m_rows.size()) - 1;
+    if (position < 0 || first > last) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), first, last);
+    m_rows.remove(first, last - first + 1);
+    endRemoveRows();
+}
+
+void NotificationListModel::removeAt(int row)
+{
+    if (row < 0 || row >= m_rows.size()) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    if (!m_rows[row].archived) {
+        shiftLiveIndex(row, -1);
+        m_liveIndex.remove(m_rows[row].data.id);
+        m_liveCount--;
+    }
+    m_rows.removeAt(row);
+    endRemoveRows();
+}
+
+void NotificationListModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_liveCount = 0;
+    m_liveIndex.clear();
+    endResetModel();
+}
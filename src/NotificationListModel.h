@@ -0,0 +1,68 @@
+#ifndef NOTIFICATIONLISTMODEL_H
+#define NOTIFICATIONLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+#include "NotificationData.h"
+#include "HistoryStore.h"
+
+// Flat list model behind the notification panel. Live notification groups
+// come first (newest first), followed by archived rows paged in from history.
+class NotificationListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        NotificationIdRole = Qt::UserRole + 1,
+        ArchivedRole
+    };
+
+    explicit NotificationListModel(QObject *parent = nullptr);
+    ~NotificationListModel();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    
+    // Direct access for the delegate, avoids copying through QVariant
+    const NotificationData& notificationAt(int row) const { return m_rows[row].data; }
+    bool isArchived(int row) const { return m_rows[row].archived; }
+    // History sequence of an archived row, -1 for live rows
+    qint64 sequenceAt(int row) const { return m_rows[row].seq; }
+    
+    // Live rows
+    int liveCount() const { return m_liveCount; }
+    int rowForId(int notificationId) const;
+    void upsertLive(const NotificationData& notification);
+    void removeLive(int notificationId);
+    void clearLive();
+    // Replaces all rows, archived ones included, with the given groups (newest first)
+    void resetLive(const QList<NotificationData>& notifications);
+    
+    // Archived rows; positions are relative to the first archived row
+    int archivedCount() const { return m_rows.size() - m_liveCount; }
+    void insertArchived(int position, const QList<HistoryRecord>& records);
+    void removeArchived(int position, int count);
+    
+    void removeAt(int row);
+    void clear();
+
+private:
+    struct Row {
+        NotificationData data;
+        bool archived;
+        qint64 seq;
+    };
+    
+    // Shifts the index entries of live rows [0, end) by delta
+    void shiftLiveIndex(int end, int delta);
+    
+    QList<Row> m_rows;
+    int m_liveCount;
+    // Notification ID -> live row, counted up from the last live row so
+    // inserting at the top leaves every other entry alone
+    QHash<int, int> m_liveIndex;
+};
+
+#endif // NOTIFICATIONLISTMODEL_H
@@ -0,0 +1,111 @@
+#include "NotificationListView.h"
+#include "NotificationDelegate.h"
+#include "RelativeTimeTicker.h"
+#include "BlobCache.h"
+
+#include <QEvent>
+#include <QScrollBar>
+
+NotificationListView::NotificationListView(QWidget *parent)
+    : QListView(parent)
+    , m_delegate(nullptr)
+{
+    m_delegate = new NotificationDelegate(this);
+    setItemDelegate(m_delegate);
+    
+    setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    verticalScrollBar()->setSingleStep(20);
+    setSelectionMode(QAbstractItemView::NoSelection);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setFocusPolicy(Qt::NoFocus);
+    setFrameShape(QFrame::NoFrame);
+    setResizeMode(QListView::Adjust);
+    setUniformItemSizes(false);
+    setMouseTracking(true);
+    viewport()->setAttribute(Qt::WA_Hover);
+    viewport()->setAutoFillBackground(false);
+    
+    connect(this, &QAbstractItemView::entered, this, &NotificationListView::onEntered);
+    connect(m_delegate, &NotificationDelegate::expandedChanged, this, &NotificationListView::onExpandedChanged);
+    connect(m_delegate, &NotificationDelegate::removeRequested, this, &NotificationListView::removeRequested);
+    connect(m_delegate, &NotificationDelegate::actionClicked, this, &NotificationListView::actionClicked);
+    connect(m_delegate, &NotificationDelegate::replyRequested, this, &NotificationListView::replyRequested);
+    
+    // Repaint just the row whose rasterized content arrived
+    connect(m_delegate, &NotificationDelegate::contentReady, this, [this](const QModelIndex& index) {
+        viewport()->update(visualRect(index));
+    });
+    
+    // Painted rows pick up the new relative time on their next paint; the
+    // viewport only repaints rows that are actually on screen
+    connect(RelativeTimeTicker::instance(), &RelativeTimeTicker::tick, this, [this]() {
+        if (isVisible()) {
+            viewport()->update();
+        }
+    });
+    
+    // Same for icons and images that finished loading
+    connect(BlobCache::instance(), &BlobCache::imageReady, this, [this]() {
+        if (isVisible()) {
+            viewport()->update();
+        }
+    });
+}
+
+NotificationListView::~NotificationListView()
+{
+}
+
+bool NotificationListView::viewportEvent(QEvent *event)
+{
+    // Moving onto a row's editor does not leave the viewport, so this only
+    // fires when the pointer leaves the list altogether
+    if (event->type() == QEvent::Leave) {
+        closeHoverEditor();
+    }
+    return QListView::viewportEvent(event);
+}
+
+void NotificationListView::showEvent(QShowEvent *event)
+{
+    RelativeTimeTicker::instance()->subscribe(this);
+    QListView::showEvent(event);
+}
+
+void NotificationListView::hideEvent(QHideEvent *event)
+{
+    RelativeTimeTicker::instance()->unsubscribe(this);
+    QListView::hideEvent(event);
+}
+
+void NotificationListView::onEntered(const QModelIndex& index)
+{
+    if (index == m_hoverIndex) {
+        return;
+    }
+    
+    closeHoverEditor();
+    m_hoverIndex = index;
+    if (index.isValid() && !isPersistentEditorOpen(index)) {
+        openPersistentEditor(index);
+    }
+}
+
+void NotificationListView::onExpandedChanged(const QModelIndex& index, bool expanded)
+{
+    // Collapsed rows go back to being painted once the pointer is elsewhere
+    if (!expanded && index != m_hoverIndex) {
+        closePersistentEditor(index);
+    }
+}
+
+void NotificationListView::closeHoverEditor()
+{
+    // Expanded rows keep their editor until they are collapsed
+    if (m_hoverIndex.isValid() && !m_delegate->isExpanded(m_hoverIndex)) {
+        closePersistentEditor(m_hoverIndex);
+    }
+    m_hoverIndex = QPersistentModelIndex();
+}
@@ -0,0 +1,43 @@
+#ifndef NOTIFICATIONLISTVIEW_H
+#define NOTIFICATIONLISTVIEW_H
+
+#include <QListView>
+#include <QPersistentModelIndex>
+
+class NotificationDelegate;
+
+// Virtualized list of notification cards. Rows are painted by
+// NotificationDelegate; a real NotificationCard is only opened as an editor
+// for the row under the mouse and for rows the user has expanded.
+class NotificationListView : public QListView
+{
+    Q_OBJECT
+
+public:
+    explicit NotificationListView(QWidget *parent = nullptr);
+    ~NotificationListView();
+
+    NotificationDelegate* notificationDelegate() const { return m_delegate; }
+
+signals:
+    void removeRequested(const QModelIndex& index);
+    void actionClicked(const QModelIndex& index, const QString& actionKey);
+    void replyRequested(const QModelIndex& index, const QString& actionKey, const QString& replyText);
+
+protected:
+    bool viewportEvent(QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void onEntered(const QModelIndex& index);
+    void onExpandedChanged(const QModelIndex& index, bool expanded);
+
+private:
+    void closeHoverEditor();
+    
+    NotificationDelegate* m_delegate;
+    QPersistentModelIndex m_hoverIndex;
+};
+
+#endif // NOTIFICATIONLISTVIEW_H
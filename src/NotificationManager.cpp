@@ -1,18 +1,42 @@
 #include "NotificationManager.h"
 #include "NotificationClient.h"
+#include "HistoryStore.h"
+#include "SearchIndex.h"
 #include "src/Logger.h"
 
 #include <QTimer>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QRandomGenerator>
 
 NotificationManager::NotificationManager(QObject *parent)
     : QObject(parent)
+    , m_totalBytes(0)
+    , m_policy(RetentionPolicy::fromSettings())
+    , m_retentionTimer(nullptr)
+    , m_history(nullptr)
+    , m_searchIndex(nullptr)
     , m_testTimer(nullptr)
     , m_client(nullptr)
     , m_nextId(1)
     , m_testNotificationCount(0)
 {
+    // Single-shot timer armed for the moment the oldest group exceeds its max age
+    m_retentionTimer = new QTimer(this);
+    m_retentionTimer->setSingleShot(true);
+    connect(m_retentionTimer, &QTimer::timeout, this, &NotificationManager::enforceRetention);
+    
+    // Open the persistent history; ingestion works without it if it fails
+    m_history = new HistoryStore(this);
+    if (!m_history->open()) {
+        Logger::warning("Notification history is unavailable, notifications will not be persisted");
+    }
+    
+    // Index the existing history in the background and follow compaction
+    m_searchIndex = new SearchIndex(m_history, this);
+    m_searchIndex->build();
+    connect(m_history, &HistoryStore::compacted, m_searchIndex, &SearchIndex::removeBefore);
+    
     // Initialize test timer for demo purposes
     m_testTimer = new QTimer(this);
     connect(m_testTimer, &QTimer::timeout, this, &NotificationManager::generateTestNotification);
@@ -33,7 +57,9 @@ NotificationManager::NotificationManager(QObject *parent)
 
 NotificationManager::~NotificationManager()
 {
-    // QObject destructor handles child objects
+    // The search thread reads from the history, so stop it first
+    delete m_searchIndex;
+    m_searchIndex = nullptr;
 }
 
 void NotificationManager::addNotification(const NotificationData& notification)
@@ -42,37 +68,260 @@ void NotificationManager::addNotification(const NotificationData& notification)
     newNotification.id = m_nextId++;
     newNotification.timestamp = QDateTime::currentDateTime();
     
-    // Limit the number of stored notifications
-    if (m_notifications.size() >= MAX_NOTIFICATIONS) {
-        m_notifications.removeFirst();
-    }
+    // Queued for the history writer thread, never blocks
+    qint64 seq = m_history->append(newNotification);
+    m_searchIndex->addDocument(seq, newNotification);
     
-    m_notifications.append(newNotification);
     emit notificationReceived(newNotification);
+    
+    NotificationData updated = storeNotification(newNotification, seq)->data;
+    enforceRetention();
+    
+    // The group that was just updated is never evicted, see enforceRetention()
+    emit notificationUpdated(updated);
+}
+
+void NotificationManager::restoreHistory(int count)
+{
+    QElapsedTimer timer;
+    timer.start();
+    
+    // Restored notifications keep their original timestamps and do not popup
+    const QList<HistoryRecord> restored = m_history->readRecent(count);
+    for (const HistoryRecord& record : restored) {
+        NotificationData notification = record.notification;
+        notification.id = m_nextId++;
+        storeNotification(notification, record.seq);
+    }
+    enforceAppQuotas();
+    enforceRetention();
+    
+    // Announce groups oldest first so views that prepend end up newest first
+    const QList<NotificationData> groups = notifications();
+    for (auto it = groups.crbegin(); it != groups.crend(); ++it) {
+        emit notificationUpdated(*it);
+    }
+    
+    Logger::info(QString("Restored %1 notifications from history in %2 ms")
+                 .arg(restored.size()).arg(timer.elapsed()));
+}
+
+bool NotificationManager::isLiveRecord(const HistoryRecord& record) const
+{
+    // Records merged into a live group are shown by that group's row; older
+    // records of the same group and records of evicted groups are not
+    auto groupIt = m_idsByGroupKey.constFind(record.notification.getGroupKey());
+    if (groupIt == m_idsByGroupKey.constEnd()) {
+        return false;
+    }
+    qint64 firstSeq = m_entriesById.value(groupIt.value())->firstSeq;
+    return firstSeq >= 0 && record.seq >= firstSeq;
+}
+
+NotificationManager::EntryIterator NotificationManager::storeNotification(const NotificationData& notification, qint64 seq)
+{
+    EntryIterator it;
+    auto groupIt = m_idsByGroupKey.constFind(notification.getGroupKey());
+    if (groupIt != m_idsByGroupKey.constEnd()) {
+        // Merge into the existing group and mark it as most recently updated
+        it = m_entriesById.value(groupIt.value());
+        it->data.mergeWith(notification);
+        if (seq >= 0 && (it->firstSeq < 0 || seq < it->firstSeq)) {
+            it->firstSeq = seq;
+        }
+        touchEntry(it);
+    } else {
+        std::list<int>& appOrder = m_appOrder[notification.appName];
+        appOrder.push_back(notification.id);
+        
+        Entry entry;
+        entry.data = notification;
+        entry.bytes = 0;
+        entry.firstSeq = seq;
+        entry.appPos = std::prev(appOrder.end());
+        it = m_entries.insert(m_entries.end(), entry);
+        
+        m_entriesById.insert(notification.id, it);
+        m_idsByGroupKey.insert(notification.getGroupKey(), notification.id);
+    }
+    
+    if (!notification.stringId.isEmpty() && !m_idsByStringId.contains(notification.stringId)) {
+        it->stringIds.append(notification.stringId);
+        m_idsByStringId.insert(notification.stringId, it->data.id);
+    }
+    
+    m_totalBytes -= it->bytes;
+    it->bytes = it->data.memoryFootprint() + it->stringIds.size() * 64;
+    m_totalBytes += it->bytes;
+    
+    return it;
 }
 
 void NotificationManager::removeNotification(int notificationId)
 {
-    for (int i = 0; i < m_notifications.size(); ++i) {
-        if (m_notifications[i].id == notificationId) {
-            QString stringId = m_notifications[i].stringId;
-            m_notifications.removeAt(i);
-            emit notificationRemoved(notificationId);
-            
-            // Send dismiss message to Android if we have a string ID and client
-            if (!stringId.isEmpty() && m_client && m_client->isConnected()) {
-                m_client->sendNotificationDismiss(stringId);
-            }
-            
-            break;
+    auto found = m_entriesById.constFind(notificationId);
+    if (found == m_entriesById.constEnd()) {
+        return;
+    }
+    
+    QStringList stringIds = found.value()->stringIds;
+    removeEntry(found.value());
+    emit notificationRemoved(notificationId);
+    
+    // Send dismiss messages to Android for every notification in the group
+    if (m_client && m_client->isConnected()) {
+        for (const QString& stringId : stringIds) {
+            m_client->sendNotificationDismiss(stringId);
         }
     }
 }
 
+void NotificationManager::removeHistoryRecord(const HistoryRecord& record)
+{
+    m_history->removeRecord(record.seq);
+    m_searchIndex->removeDocument(record.seq, record.notification);
+}
+
 void NotificationManager::clearAllNotifications()
 {
-    m_notifications.clear();
-    // Could emit a signal here if needed
+    // Everything appended so far stays out of restore, paging and search
+    m_searchIndex->removeBefore(m_history->removeAll());
+    
+    m_entries.clear();
+    m_entriesById.clear();
+    m_idsByGroupKey.clear();
+    m_idsByStringId.clear();
+    m_appOrder.clear();
+    m_totalBytes = 0;
+    m_retentionTimer->stop();
+    
+    emit notificationsCleared();
+}
+
+QList<NotificationData> NotificationManager::notifications() const
+{
+    QList<NotificationData> result;
+    result.reserve(static_cast<qsizetype>(m_entries.size()));
+    for (auto it = m_entries.crbegin(); it != m_entries.crend(); ++it) {
+        result.append(it->data);
+    }
+    return result;
+}
+
+void NotificationManager::setRetentionPolicy(const RetentionPolicy& policy)
+{
+    m_policy = policy;
+    enforceAppQuotas();
+    enforceRetention();
+}
+
+void NotificationManager::removeEntry(EntryIterator it)
+{
+    const QString appName = it->data.appName;
+    auto appIt = m_appOrder.find(appName);
+    if (appIt != m_appOrder.end()) {
+        appIt->erase(it->appPos);
+        if (appIt->empty()) {
+            m_appOrder.erase(appIt);
+        }
+    }
+    
+    for (const QString& stringId : it->stringIds) {
+        m_idsByStringId.remove(stringId);
+    }
+    m_idsByGroupKey.remove(it->data.getGroupKey());
+    m_entriesById.remove(it->data.id);
+    m_totalBytes -= it->bytes;
+    m_entries.erase(it);
+}
+
+void NotificationManager::touchEntry(EntryIterator it)
+{
+    // Move to the most-recently-updated end of both orders in O(1)
+    m_entries.splice(m_entries.end(), m_entries, it);
+    
+    std::list<int>& appOrder = m_appOrder[it->data.appName];
+    appOrder.splice(appOrder.end(), appOrder, it->appPos);
+}
+
+void NotificationManager::enforceRetention()
+{
+    // Count, quota and memory limits never evict the most recently updated
+    // group, so the notification that triggered enforcement stays visible
+    
+    // Per-app quota: on a single add only the app of the newest group can
+    // have grown; bulk changes go through enforceAppQuotas() first
+    if (m_policy.maxPerApp > 0 && !m_entries.empty()) {
+        enforceAppQuota(m_entries.back().data.appName);
+    }
+    
+    // Global count
+    while (m_policy.maxNotifications > 0 && m_entries.size() > 1
+           && static_cast<int>(m_entries.size()) > m_policy.maxNotifications) {
+        evictEntry(m_entries.begin());
+    }
+    
+    // Memory budget
+    while (m_policy.maxMemoryBytes > 0 && m_entries.size() > 1 && m_totalBytes > m_policy.maxMemoryBytes) {
+        evictEntry(m_entries.begin());
+    }
+    
+    // Max age: entries are ordered by last update, so only the front needs checking
+    if (m_policy.maxAgeSecs > 0) {
+        QDateTime cutoff = QDateTime::currentDateTime().addSecs(-m_policy.maxAgeSecs);
+        while (!m_entries.empty() && m_entries.front().data.timestamp < cutoff) {
+            evictEntry(m_entries.begin());
+        }
+    }
+    
+    scheduleAgeCheck();
+}
+
+void NotificationManager::enforceAppQuotas()
+{
+    // Restores and policy changes can leave any app over its quota
+    if (m_policy.maxPerApp <= 0) {
+        return;
+    }
+    
+    const QStringList appNames = m_appOrder.keys();
+    for (const QString& appName : appNames) {
+        enforceAppQuota(appName);
+    }
+}
+
+void NotificationManager::enforceAppQuota(const QString& appName)
+{
+    auto appIt = m_appOrder.find(appName);
+    while (appIt != m_appOrder.end() && static_cast<int>(appIt->size()) > m_policy.maxPerApp) {
+        // The most recently updated group is kept even if it is over quota
+        EntryIterator oldest = m_entriesById.value(appIt->front());
+        if (std::next(oldest) == m_entries.end()) {
+            break;
+        }
+        evictEntry(oldest);
+        appIt = m_appOrder.find(appName);
+    }
+}
+
+void NotificationManager::evictEntry(EntryIterator it)
+{
+    int id = it->data.id;
+    removeEntry(it);
+    Logger::debug(QString("Retention evicted notification group %1").arg(id));
+    emit notificationRemoved(id);
+}
+
+void NotificationManager::scheduleAgeCheck()
+{
+    if (m_policy.maxAgeSecs <= 0 || m_entries.empty()) {
+        m_retentionTimer->stop();
+        return;
+    }
+    
+    QDateTime expiry = m_entries.front().data.timestamp.addSecs(m_policy.maxAgeSecs);
+    qint64 msecs = qBound<qint64>(1000, QDateTime::currentDateTime().msecsTo(expiry), 3600 * 1000);
+    m_retentionTimer->start(static_cast<int>(msecs));
 }
 
 void NotificationManager::addDummyNotifications()
@@ -177,15 +426,15 @@ void NotificationManager::onClientNotificationReceived(const NotificationData& n
 
 void NotificationManager::onClientNotificationDismissed(const QString& notificationId)
 {
-    // Find and remove the notification with the matching string ID
-    for (int i = 0; i < m_notifications.size(); ++i) {
-        if (m_notifications[i].stringId == notificationId) {
-            int intId = m_notifications[i].id;
-            m_notifications.removeAt(i);
-            emit notificationRemoved(intId);
-            break;
-        }
+    // Find and remove the group containing the matching string ID
+    auto found = m_idsByStringId.constFind(notificationId);
+    if (found == m_idsByStringId.constEnd()) {
+        return;
     }
+    
+    int intId = found.value();
+    removeEntry(m_entriesById.value(intId));
+    emit notificationRemoved(intId);
 }
 
 void NotificationManager::onClientConnected()
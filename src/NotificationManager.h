@@ -3,10 +3,16 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
 #include <QTimer>
+#include <list>
 #include "NotificationData.h"
+#include "RetentionPolicy.h"
 
 class NotificationClient;
+class HistoryStore;
+class SearchIndex;
+struct HistoryRecord;
 
 class NotificationManager : public QObject
 {
@@ -20,6 +26,26 @@ public:
     void removeNotification(int notificationId);
     void clearAllNotifications();
     
+    // Retention
+    void setRetentionPolicy(const RetentionPolicy& policy);
+    const RetentionPolicy& retentionPolicy() const { return m_policy; }
+    int notificationCount() const { return static_cast<int>(m_entries.size()); }
+    qint64 memoryUsage() const { return m_totalBytes; }
+    
+    // Stored notification groups, newest first
+    QList<NotificationData> notifications() const;
+    
+    // Persistent history
+    HistoryStore* history() const { return m_history; }
+    SearchIndex* searchIndex() const { return m_searchIndex; }
+    void restoreHistory(int count = RESTORE_COUNT);
+    // Whether a history record is already shown as part of a live group
+    bool isLiveRecord(const HistoryRecord& record) const;
+    // Deletes a single archived record from restore, paging and search
+    void removeHistoryRecord(const HistoryRecord& record);
+    
+    static constexpr int RESTORE_COUNT = 100;
+    
     // Network connectivity
     void startNetworkClient();
     void stopNetworkClient();
@@ -32,8 +58,12 @@ public:
     void addDummyNotifications();
 
 signals:
+    // Emitted once per incoming notification, before grouping
     void notificationReceived(const NotificationData& notification);
+    // Emitted with the merged group whenever a group is created or updated
+    void notificationUpdated(const NotificationData& notification);
     void notificationRemoved(int notificationId);
+    void notificationsCleared();
     void serverConnected();
     void serverDisconnected();
     void connectionError(const QString& error);
@@ -45,15 +75,43 @@ private slots:
     void onClientConnected();
     void onClientDisconnected();
     void onClientError(const QString& error);
+    void enforceRetention();
 
 private:
-    QList<NotificationData> m_notifications;
+    // A stored notification group. Entries are kept oldest-updated first so
+    // the front is always the next candidate for eviction.
+    struct Entry {
+        NotificationData data;
+        qint64 bytes;
+        QStringList stringIds;            // Protocol IDs of every merged notification
+        qint64 firstSeq;                  // History sequence of the oldest merged notification
+        std::list<int>::iterator appPos;  // Position in the per-app order list
+    };
+    using EntryIterator = std::list<Entry>::iterator;
+    
+    EntryIterator storeNotification(const NotificationData& notification, qint64 seq);
+    void removeEntry(EntryIterator it);
+    void touchEntry(EntryIterator it);
+    void evictEntry(EntryIterator it);
+    void enforceAppQuotas();
+    void enforceAppQuota(const QString& appName);
+    void scheduleAgeCheck();
+    
+    std::list<Entry> m_entries;
+    QHash<int, EntryIterator> m_entriesById;
+    QHash<QString, int> m_idsByGroupKey;
+    QHash<QString, int> m_idsByStringId;
+    QHash<QString, std::list<int>> m_appOrder;  // Group IDs per app, oldest-updated first
+    qint64 m_totalBytes;
+    
+    RetentionPolicy m_policy;
+    QTimer* m_retentionTimer;
+    HistoryStore* m_history;
+    SearchIndex* m_searchIndex;
     QTimer* m_testTimer;
     NotificationClient* m_client;
     int m_nextId;
     int m_testNotificationCount;
-    
-    static constexpr int MAX_NOTIFICATIONS = 100;
 };
 
 #endif // NOTIFICATIONMANAGER_H
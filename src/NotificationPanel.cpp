@@ -1,29 +1,60 @@
 #include "NotificationPanel.h"
-#include "NotificationCard.h"
+#include "BackgroundCache.h"
+#include "NotificationListView.h"
+#include "NotificationListModel.h"
 #include "NotificationManager.h"
 #include "NotificationClient.h"
+#include "NotificationDelegate.h"
+#include "SearchIndex.h"
+#include "Logger.h"
 
 #include <QApplication>
 #include <QScreen>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QScrollArea>
 #include <QLabel>
 #include <QPushButton>
 #include <QScrollBar>
 #include <QPainter>
 #include <QStyleOption>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+#include <malloc.h>
+#endif
 
 NotificationPanel::NotificationPanel(QWidget *parent)
     : QWidget(parent)
     , m_mainLayout(nullptr)
-    , m_scrollArea(nullptr)
-    , m_scrollWidget(nullptr)
-    , m_scrollLayout(nullptr)
+    , m_listView(nullptr)
+    , m_model(nullptr)
     , m_emptyLabel(nullptr)
     , m_clearButton(nullptr)
+    , m_searchField(nullptr)
+    , m_searchView(nullptr)
+    , m_searchModel(nullptr)
+    , m_noResultsLabel(nullptr)
+    , m_searchRequestId(0)
+    , m_historyWatcher(nullptr)
+    , m_historyBoundary(-1)
+    , m_pendingFirstSeq(0)
+    , m_pendingEndSeq(0)
+    , m_pendingPrepend(false)
+    , m_newPill(nullptr)
+    , m_trimTimer(nullptr)
+    , m_trimmed(false)
     , m_notificationManager(nullptr)
 {
+    m_trimTimer = new QTimer(this);
+    m_trimTimer->setSingleShot(true);
+    m_trimTimer->setInterval(TRIM_DELAY_MS);
+    connect(m_trimTimer, &QTimer::timeout, this, &NotificationPanel::trimMemory);
+    
+    m_historyWatcher = new QFutureWatcher<QList<HistoryRecord>>(this);
+    connect(m_historyWatcher, &QFutureWatcher<QList<HistoryRecord>>::finished,
+            this, &NotificationPanel::onHistoryPageLoaded);
+    
     setupUI();
     positionPanel();
     
@@ -38,7 +69,8 @@ NotificationPanel::NotificationPanel(QWidget *parent)
 
 NotificationPanel::~NotificationPanel()
 {
-    // QWidget destructor will handle child widgets
+    // A page read may still be using the history store
+    m_historyWatcher->waitForFinished();
 }
 
 void NotificationPanel::setupUI()
@@ -54,46 +86,14 @@ void NotificationPanel::setupUI()
     
     // Create title
     QLabel* titleLabel = new QLabel("Notifications", this);
-    titleLabel->setObjectName("titleLabel");
-    titleLabel->setStyleSheet(
-        "QLabel#titleLabel {"
-        "    font-size: 18px;"
-        "    font-weight: bold;"
-        "    color: white;"
-        "    padding: 10px;"
-        "    background-color: rgba(0, 0, 0, 0.8);"
-        "    border-radius: 8px;"
-        "}"
-    );
+    titleLabel->setObjectName("panelTitleLabel");
     
     // Create clear button
     m_clearButton = new QPushButton("Clear All", this);
     m_clearButton->setObjectName("clearButton");
-    m_clearButton->setStyleSheet(
-        "QPushButton#clearButton {"
-        "    font-size: 12px;"
-        "    font-weight: bold;"
-        "    color: white;"
-        "    background-color: rgba(200, 60, 60, 0.8);"
-        "    border: 1px solid rgba(255, 255, 255, 0.2);"
-        "    border-radius: 6px;"
-        "    padding: 6px 12px;"
-        "    min-width: 60px;"
-        "}"
-        "QPushButton#clearButton:hover {"
-        "    background-color: rgba(220, 80, 80, 0.9);"
-        "}"
-        "QPushButton#clearButton:pressed {"
-        "    background-color: rgba(180, 40, 40, 0.9);"
-        "}"
-        "QPushButton#clearButton:disabled {"
-        "    background-color: rgba(100, 100, 100, 0.5);"
-        "    color: rgba(255, 255, 255, 0.4);"
-        "}"
-    );
     
     // Connect clear button to slot
-    connect(m_clearButton, &QPushButton::clicked, this, &NotificationPanel::clearAllNotifications);
+    connect(m_clearButton, &QPushButton::clicked, this, &NotificationPanel::onClearClicked);
     
     // Add widgets to header layout
     headerLayout->addWidget(titleLabel);
@@ -103,83 +103,56 @@ void NotificationPanel::setupUI()
     // Create a header widget to contain the layout
     QWidget* headerWidget = new QWidget(this);
     headerWidget->setLayout(headerLayout);
-    headerWidget->setStyleSheet(
-        "QWidget {"
-        "    background-color: transparent;"
-        "    margin-bottom: 10px;"
-        "}"
-    );
+    headerWidget->setObjectName("panelHeader");
     
     m_mainLayout->addWidget(headerWidget);
     
-    setupScrollArea();
-    
-    // Set panel styling
-    setStyleSheet(
-        "NotificationPanel {"
-        "    background-color: rgba(30, 30, 30, 0.9);"
-        "    border-radius: 12px;"
-        "    border: 1px solid rgba(255, 255, 255, 0.1);"
-        "}"
-    );
-}
-
-void NotificationPanel::setupScrollArea()
-{
-    // Create scroll area
-    m_scrollArea = new QScrollArea(this);
-    m_scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    m_scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-    m_scrollArea->setWidgetResizable(true);
-    m_scrollArea->setFrameShape(QFrame::NoFrame);
-    
-    // Create scroll widget and layout
-    m_scrollWidget = new QWidget();
-    m_scrollWidget->setStyleSheet(
-        "QWidget {"
-        "    background-color: transparent;"
-        "}"
-    );
-    m_scrollLayout = new QVBoxLayout(m_scrollWidget);
-    m_scrollLayout->setContentsMargins(0, 0, 6, 0);
-    m_scrollLayout->setSpacing(8);
-    m_scrollLayout->addStretch(); // Push notifications to top
+    // Search field filters the whole history as the user types
+    m_searchField = new QLineEdit(this);
+    m_searchField->setObjectName("searchField");
+    m_searchField->setPlaceholderText("Search notifications...");
+    m_searchField->setClearButtonEnabled(true);
+    connect(m_searchField, &QLineEdit::textChanged, this, &NotificationPanel::onSearchTextChanged);
+    m_mainLayout->addWidget(m_searchField);
     
+    setupListView();
+    setupSearchView();
+    
+    // Styling comes from the application stylesheet (styles.qss)
+}
+
+void NotificationPanel::setupListView()
+{
     // Create empty state label
-    m_emptyLabel = new QLabel("No notifications", m_scrollWidget);
+    m_emptyLabel = new QLabel("No notifications", this);
     m_emptyLabel->setAlignment(Qt::AlignCenter);
-    m_emptyLabel->setStyleSheet(
-        "QLabel {"
-        "    color: rgba(255, 255, 255, 0.6);"
-        "    font-size: 14px;"
-        "    padding: 40px;"
-        "}"
-    );
-    m_scrollLayout->addWidget(m_emptyLabel);
-    
-    m_scrollArea->setWidget(m_scrollWidget);
-    m_mainLayout->addWidget(m_scrollArea);
-    
-    // Style scroll area
-    m_scrollArea->setStyleSheet(
-        "QScrollArea {"
-        "    background-color: transparent;"
-        "    border: none;"
-        "}"
-        "QScrollBar:vertical {"
-        "    background-color: rgba(255, 255, 255, 0.1);"
-        "    width: 4px;"
-        "    border-radius: 4px;"
-        "}"
-        "QScrollBar::handle:vertical {"
-        "    background-color: rgba(255, 255, 255, 0.3);"
-        "    border-radius: 4px;"
-        "    min-height: 20px;"
-        "}"
-        "QScrollBar::handle:vertical:hover {"
-        "    background-color: rgba(255, 255, 255, 0.5);"
-        "}"
-    );
+    m_emptyLabel->setObjectName("emptyLabel");
+    m_mainLayout->addWidget(m_emptyLabel);
+    
+    // Rows are painted by the view's delegate, so thousands of entries stay cheap
+    m_model = new NotificationListModel(this);
+    m_listView = new NotificationListView(this);
+    m_listView->setModel(m_model);
+    m_mainLayout->addWidget(m_listView, 1);
+    
+    connect(m_listView, &NotificationListView::removeRequested, this, &NotificationPanel::onRemoveRequested);
+    connect(m_listView, &NotificationListView::actionClicked, this, &NotificationPanel::onActionClicked);
+    connect(m_listView, &NotificationListView::replyRequested, this, &NotificationPanel::onReplyRequested);
+    
+    // Page history in and out as the user scrolls, or when content is too short to scroll
+    QScrollBar* scrollBar = m_listView->verticalScrollBar();
+    connect(scrollBar, &QScrollBar::valueChanged, this, &NotificationPanel::onScrollValueChanged);
+    connect(scrollBar, &QScrollBar::rangeChanged, this, [this, scrollBar]() {
+        onScrollValueChanged(scrollBar->value());
+    });
+    
+    // Floats over the list rather than taking a layout slot, so showing it
+    // never moves the rows
+    m_newPill = new QPushButton(m_listView);
+    m_newPill->setObjectName("newPill");
+    m_newPill->setCursor(Qt::PointingHandCursor);
+    m_newPill->hide();
+    connect(m_newPill, &QPushButton::clicked, this, &NotificationPanel::onNewPillClicked);
 }
 
 void NotificationPanel::positionPanel()
@@ -195,121 +168,442 @@ void NotificationPanel::positionPanel()
     }
 }
 
+void NotificationPanel::setupSearchView()
+{
+    m_noResultsLabel = new QLabel("No matching notifications", this);
+    m_noResultsLabel->setAlignment(Qt::AlignCenter);
+    m_noResultsLabel->setObjectName("noResultsLabel");
+    m_noResultsLabel->hide();
+    m_mainLayout->addWidget(m_noResultsLabel);
+    
+    m_searchModel = new NotificationListModel(this);
+    m_searchView = new NotificationListView(this);
+    m_searchView->setModel(m_searchModel);
+    m_mainLayout->addWidget(m_searchView, 1);
+    m_searchView->hide();
+    
+    // Results are history records; removing one tombstones it
+    connect(m_searchView, &NotificationListView::removeRequested, this, [this](const QModelIndex& index) {
+        if (m_notificationManager) {
+            m_notificationManager->removeHistoryRecord({m_searchModel->sequenceAt(index.row()),
+                                                        m_searchModel->notificationAt(index.row())});
+        }
+        m_searchModel->removeAt(index.row());
+    });
+}
+
 void NotificationPanel::setNotificationManager(NotificationManager* manager)
 {
     m_notificationManager = manager;
+    
+    if (m_notificationManager && m_notificationManager->searchIndex()) {
+        connect(m_notificationManager->searchIndex(), &SearchIndex::resultsReady,
+                this, &NotificationPanel::onSearchResults);
+    }
 }
 
 void NotificationPanel::addNotification(const NotificationData& notification)
 {
-    // Hide empty label if visible
-    if (m_emptyLabel->isVisible()) {
-        m_emptyLabel->hide();
+    // While trimmed the manager is the only copy; the rows are rebuilt on show
+    if (m_trimmed) {
+        return;
+    }
+    
+    applyLiveUpdates({notification});
+    updateEmptyState();
+}
+
+void NotificationPanel::addNotifications(const QList<NotificationData>& notifications)
+{
+    if (notifications.isEmpty() || m_trimmed) {
+        return;
     }
     
-    // Check if we should group this notification with an existing one
-    QString groupKey = notification.getGroupKey();
-    NotificationCard* existingCard = nullptr;
+    applyLiveUpdates(notifications);
+    updateEmptyState();
+}
+
+void NotificationPanel::applyLiveUpdates(const QList<NotificationData>& notifications)
+{
+    QScrollBar* scrollBar = m_listView->verticalScrollBar();
+    bool atTop = scrollBar->value() <= scrollBar->minimum();
     
-    // Look for an existing notification with the same group key
-    for (NotificationCard* card : m_notificationCards) {
-        if (card->getNotificationData().getGroupKey() == groupKey) {
-            existingCard = card;
-            break;
+    // Reading further down: pin the first visible row that is not itself
+    // moving to the top, and put it back where it was after the update
+    QPersistentModelIndex anchor;
+    int anchorTop = 0;
+    if (!atTop) {
+        QSet<int> updatedIds;
+        for (const NotificationData& notification : notifications) {
+            updatedIds.insert(notification.id);
+        }
+        anchor = firstVisibleRow(updatedIds);
+        if (anchor.isValid()) {
+            anchorTop = m_listView->visualRect(anchor).top();
         }
     }
     
-    if (existingCard) {
-        // Merge with existing notification
-        NotificationData updatedData = existingCard->getNotificationData();
-        updatedData.mergeWith(notification);
-        
-        // Update the existing card with merged data
-        existingCard->updateNotificationData(updatedData);
-        
-        // Move the updated card to the top (newest first)
-        int currentIndex = m_notificationCards.indexOf(existingCard);
-        if (currentIndex > 0) {
-            m_scrollLayout->removeWidget(existingCard);
-            m_notificationCards.removeAt(currentIndex);
-            
-            m_scrollLayout->insertWidget(0, existingCard);
-            m_notificationCards.prepend(existingCard);
+    // Notifications arrive already grouped by the manager, so an existing
+    // row with the same ID is an update of that group and moves to the top
+    // as a single model move; the view lays out once for the whole batch
+    for (const NotificationData& notification : notifications) {
+        m_model->upsertLive(notification);
+    }
+    
+    if (atTop) {
+        m_listView->scrollToTop();
+        return;
+    }
+    
+    if (anchor.isValid()) {
+        scrollToKeep(anchor, anchorTop);
+    }
+    for (const NotificationData& notification : notifications) {
+        m_unseenIds.insert(notification.id);
+    }
+    updateNewPill();
+}
+
+QPersistentModelIndex NotificationPanel::firstVisibleRow(const QSet<int>& skipIds) const
+{
+    int viewportHeight = m_listView->viewport()->height();
+    QModelIndex top = m_listView->indexAt(QPoint(m_listView->viewport()->width() / 2, 0));
+    
+    for (int row = top.isValid() ? top.row() : 0; row < m_model->rowCount(); ++row) {
+        QModelIndex index = m_model->index(row);
+        QRect rect = m_listView->visualRect(index);
+        if (rect.top() >= viewportHeight) {
+            break;
         }
-    } else {
-        // Create new notification card
-        NotificationCard* card = new NotificationCard(notification, m_scrollWidget);
-        
-        // Connect card signals
-        connect(card, &NotificationCard::removeRequested,
-                this, [this, card]() {
-                    removeNotification(card->getNotificationId());
-                });
-        
-        // Connect action signals to notification client
-        if (m_notificationManager && m_notificationManager->getClient()) {
-            auto client = m_notificationManager->getClient();
-            
-            connect(card, &NotificationCard::actionClicked,
-                    this, [client, card](const QString& actionKey) {
-                        client->sendNotificationAction(card->getNotificationData().stringId, actionKey);
-                    });
-            
-            connect(card, &NotificationCard::replyRequested,
-                    this, [client, card](const QString& actionKey, const QString& replyText) {
-                        client->sendNotificationReply(card->getNotificationData().stringId, actionKey, replyText);
-                    });
+        bool moving = !m_model->isArchived(row) && skipIds.contains(m_model->notificationAt(row).id);
+        if (rect.bottom() >= 0 && !moving) {
+            return QPersistentModelIndex(index);
         }
-        
-        // Insert at the beginning (newest first)
-        m_scrollLayout->insertWidget(0, card);
-        m_notificationCards.prepend(card);
+    }
+    return QPersistentModelIndex();
+}
+
+void NotificationPanel::clearUnseen()
+{
+    m_unseenIds.clear();
+    updateNewPill();
+}
+
+void NotificationPanel::updateNewPill()
+{
+    if (m_unseenIds.isEmpty()) {
+        m_newPill->hide();
+        return;
     }
     
-    // Scroll to top to show new/updated notification
-    m_scrollArea->verticalScrollBar()->setValue(0);
+    m_newPill->setText(QString("%1 new").arg(m_unseenIds.size()));
+    m_newPill->adjustSize();
+    m_newPill->move((m_listView->width() - m_newPill->width()) / 2, NEW_PILL_MARGIN);
+    m_newPill->show();
+    m_newPill->raise();
+}
+
+void NotificationPanel::onNewPillClicked()
+{
+    m_listView->scrollToTop();
+    clearUnseen();
+}
+
+void NotificationPanel::removeNotification(int notificationId)
+{
+    if (m_trimmed) {
+        return;
+    }
+    m_model->removeLive(notificationId);
+    if (m_unseenIds.remove(notificationId)) {
+        updateNewPill();
+    }
+    updateEmptyState();
+}
+
+void NotificationPanel::removeNotifications(const QList<int>& notificationIds)
+{
+    if (m_trimmed) {
+        return;
+    }
+    bool unseenRemoved = false;
+    for (int notificationId : notificationIds) {
+        m_model->removeLive(notificationId);
+        unseenRemoved = m_unseenIds.remove(notificationId) || unseenRemoved;
+    }
+    if (unseenRemoved) {
+        updateNewPill();
+    }
+    updateEmptyState();
+}
+
+void NotificationPanel::clearAllNotifications()
+{
+    if (m_trimmed) {
+        return;
+    }
+    m_model->clearLive();
+    clearHistoryPages();
+    clearUnseen();
     
     updateEmptyState();
 }
 
-void NotificationPanel::removeNotification(int notificationId)
+void NotificationPanel::onRemoveRequested(const QModelIndex& index)
 {
-    // Find the notification card and get its string ID for dismiss
-    QString stringId;
-    for (int i = 0; i < m_notificationCards.size(); ++i) {
-        NotificationCard* card = m_notificationCards[i];
-        if (card->getNotificationId() == notificationId) {
-            stringId = card->getNotificationData().stringId;
-            m_scrollLayout->removeWidget(card);
-            m_notificationCards.removeAt(i);
-            card->deleteLater();
+    int row = index.row();
+    if (row < 0 || row >= m_model->rowCount()) {
+        return;
+    }
+    
+    if (!m_model->isArchived(row)) {
+        // The manager owns the store and reports the removal back
+        int notificationId = m_model->notificationAt(row).id;
+        if (m_notificationManager) {
+            m_notificationManager->removeNotification(notificationId);
+        } else {
+            removeNotification(notificationId);
+        }
+        return;
+    }
+    
+    // Archived rows are tombstoned so paging and search skip them too
+    if (m_notificationManager) {
+        m_notificationManager->removeHistoryRecord({m_model->sequenceAt(row), m_model->notificationAt(row)});
+    }
+    int position = row - m_model->liveCount();
+    for (HistoryPage& page : m_historyPages) {
+        if (position < page.rowCount) {
+            page.rowCount--;
             break;
         }
+        position -= page.rowCount;
+    }
+    m_model->removeAt(row);
+}
+
+void NotificationPanel::onActionClicked(const QModelIndex& index, const QString& actionKey)
+{
+    if (!m_notificationManager || !m_notificationManager->getClient() || m_model->isArchived(index.row())) {
+        return;
+    }
+    m_notificationManager->getClient()->sendNotificationAction(
+        m_model->notificationAt(index.row()).stringId, actionKey);
+}
+
+void NotificationPanel::onReplyRequested(const QModelIndex& index, const QString& actionKey, const QString& replyText)
+{
+    if (!m_notificationManager || !m_notificationManager->getClient() || m_model->isArchived(index.row())) {
+        return;
+    }
+    m_notificationManager->getClient()->sendNotificationReply(
+        m_model->notificationAt(index.row()).stringId, actionKey, replyText);
+}
+
+void NotificationPanel::onClearClicked()
+{
+    // Clear the store too; it reports back through notificationsCleared()
+    if (m_notificationManager) {
+        m_notificationManager->clearAllNotifications();
+    } else {
+        clearAllNotifications();
+    }
+}
+
+void NotificationPanel::onScrollValueChanged(int value)
+{
+    // Back at the top, everything new has been seen
+    if (!m_unseenIds.isEmpty() && value <= m_listView->verticalScrollBar()->minimum()) {
+        clearUnseen();
+    }
+    
+    if (!m_notificationManager || m_historyWatcher->isRunning()) {
+        return;
+    }
+    HistoryStore* history = m_notificationManager->history();
+    if (!history || !history->isOpen()) {
+        return;
+    }
+    
+    // Scrolled back up to where newer pages were dropped: reload the neighbour
+    if (!m_historyPages.isEmpty() && m_historyPages.first().endSeq < m_historyBoundary
+        && m_model->archivedCount() > 0) {
+        QModelIndex firstRow = m_model->index(m_model->liveCount());
+        if (m_listView->visualRect(firstRow).top() > -HISTORY_PREFETCH_MARGIN) {
+            qint64 firstSeq = m_historyPages.first().endSeq;
+            requestHistoryPage(firstSeq, qMin(firstSeq + HISTORY_PAGE_SIZE, m_historyBoundary), true);
+            return;
+        }
     }
     
-    // Notify the notification manager to handle the dismiss (which will send to Android)
-    if (m_notificationManager && !stringId.isEmpty()) {
-        m_notificationManager->removeNotification(notificationId);
+    // Near the bottom: load the next older page
+    if (value >= m_listView->verticalScrollBar()->maximum() - HISTORY_PREFETCH_MARGIN) {
+        // Browse everything on disk; records of live groups are skipped as
+        // pages load, so records of evicted groups are not lost
+        if (m_historyBoundary < 0) {
+            m_historyBoundary = history->endSequence();
+        }
+        qint64 endSeq = m_historyPages.isEmpty() ? m_historyBoundary : m_historyPages.last().firstSeq;
+        qint64 firstSeq = qMax(history->firstSequence(), endSeq - HISTORY_PAGE_SIZE);
+        if (firstSeq < endSeq) {
+            requestHistoryPage(firstSeq, endSeq, false);
+        }
     }
+}
+
+void NotificationPanel::requestHistoryPage(qint64 firstSeq, qint64 endSeq, bool prepend)
+{
+    m_pendingFirstSeq = firstSeq;
+    m_pendingEndSeq = endSeq;
+    m_pendingPrepend = prepend;
     
-    updateEmptyState();
+    // Read and decode off the GUI thread; only the model insert happens here
+    HistoryStore* history = m_notificationManager->history();
+    int count = static_cast<int>(endSeq - firstSeq);
+    m_historyWatcher->setFuture(QtConcurrent::run([history, firstSeq, count]() {
+        return history->read(firstSeq, count);
+    }));
 }
 
-void NotificationPanel::clearAllNotifications()
+void NotificationPanel::onHistoryPageLoaded()
 {
-    for (NotificationCard* card : m_notificationCards) {
-        m_scrollLayout->removeWidget(card);
-        card->deleteLater();
+    // The panel was cleared while the page was loading
+    if (m_historyBoundary < 0) {
+        return;
     }
-    m_notificationCards.clear();
     
-    updateEmptyState();
+    // Newest first, like the live rows above, without the records the live
+    // groups already show
+    const QList<HistoryRecord> records = m_historyWatcher->result();
+    QList<HistoryRecord> rows;
+    rows.reserve(records.size());
+    for (auto it = records.crbegin(); it != records.crend(); ++it) {
+        if (!m_notificationManager->isLiveRecord(*it)) {
+            rows.append(*it);
+        }
+    }
+    
+    HistoryPage page;
+    page.firstSeq = m_pendingFirstSeq;
+    page.endSeq = m_pendingEndSeq;
+    page.rowCount = rows.size();
+    
+    // Keep the rows in view still while pages above them come and go
+    QPersistentModelIndex anchor;
+    int pageIndex = 0;
+    
+    if (m_pendingPrepend) {
+        if (m_model->archivedCount() > 0) {
+            anchor = m_model->index(m_model->liveCount());
+        }
+        m_historyPages.prepend(page);
+    } else {
+        m_historyPages.append(page);
+        pageIndex = m_historyPages.size() - 1;
+        if (m_historyPages.size() > MAX_HISTORY_PAGES) {
+            int position = historyRowPosition(1);
+            if (position < m_model->archivedCount()) {
+                anchor = m_model->index(m_model->liveCount() + position);
+            }
+        }
+    }
+    int anchorTop = anchor.isValid() ? m_listView->visualRect(anchor).top() : 0;
+    
+    m_model->insertArchived(historyRowPosition(pageIndex), rows);
+    
+    // Cap RAM by dropping the page farthest from the one just loaded
+    if (m_historyPages.size() > MAX_HISTORY_PAGES) {
+        removeHistoryPage(m_pendingPrepend ? m_historyPages.size() - 1 : 0);
+    }
+    
+    if (anchor.isValid()) {
+        scrollToKeep(anchor, anchorTop);
+    }
+    
+    // A page of live records adds no rows and so no scrolling; keep going
+    // while the viewport is still at the edge
+    if (page.rowCount == 0) {
+        onScrollValueChanged(m_listView->verticalScrollBar()->value());
+    }
+}
+
+void NotificationPanel::removeHistoryPage(int pageIndex)
+{
+    m_model->removeArchived(historyRowPosition(pageIndex), m_historyPages[pageIndex].rowCount);
+    m_historyPages.removeAt(pageIndex);
+}
+
+void NotificationPanel::clearHistoryPages()
+{
+    while (!m_historyPages.isEmpty()) {
+        removeHistoryPage(0);
+    }
+    m_historyBoundary = -1;
+}
+
+int NotificationPanel::historyRowPosition(int pageIndex) const
+{
+    // Position of the page's first row among the archived rows
+    int position = 0;
+    for (int i = 0; i < pageIndex; ++i) {
+        position += m_historyPages[i].rowCount;
+    }
+    return position;
+}
+
+void NotificationPanel::scrollToKeep(const QPersistentModelIndex& anchor, int anchorTop)
+{
+    // Lay the rows out now so the scroll position is corrected before the
+    // next paint instead of after it
+    m_listView->doItemsLayout();
+    QScrollBar* scrollBar = m_listView->verticalScrollBar();
+    scrollBar->setValue(scrollBar->value() + m_listView->visualRect(anchor).top() - anchorTop);
+}
+
+void NotificationPanel::onSearchTextChanged(const QString& text)
+{
+    if (text.trimmed().isEmpty()) {
+        // Leave search mode and drop any result that is still in flight
+        m_searchRequestId = 0;
+        clearSearchResults();
+        m_searchView->hide();
+        m_listView->show();
+        updateEmptyState();
+        return;
+    }
+    
+    if (m_notificationManager && m_notificationManager->searchIndex()) {
+        m_searchRequestId = m_notificationManager->searchIndex()->search(text);
+    }
+}
+
+void NotificationPanel::onSearchResults(quint64 requestId, const QList<HistoryRecord>& results)
+{
+    // Only the latest query is shown
+    if (requestId != m_searchRequestId) {
+        return;
+    }
+    
+    m_searchModel->clear();
+    m_searchModel->insertArchived(0, results);
+    
+    m_noResultsLabel->setVisible(results.isEmpty());
+    m_emptyLabel->hide();
+    m_listView->hide();
+    m_searchView->show();
+    m_searchView->scrollToTop();
+}
+
+void NotificationPanel::clearSearchResults()
+{
+    m_searchModel->clear();
+    m_noResultsLabel->hide();
 }
 
 void NotificationPanel::updateEmptyState()
 {
-    bool isEmpty = m_notificationCards.isEmpty();
-    m_emptyLabel->setVisible(isEmpty);
+    bool isEmpty = m_model->liveCount() == 0;
+    m_emptyLabel->setVisible(isEmpty && m_searchView->isHidden());
     
     // Enable/disable clear button based on whether there are notifications
     if (m_clearButton) {
@@ -321,14 +615,82 @@ void NotificationPanel::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event)
     
-    // Paint semi-transparent background
+    // Paint semi-transparent rounded background from the cached nine-patch
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
+    BackgroundCache::draw(&painter, rect(), BackgroundCache::panelStyle());
+}
+
+void NotificationPanel::showEvent(QShowEvent *event)
+{
+    // Normally done by the caller before the slide-in snapshot is taken
+    restoreIfTrimmed();
+    QWidget::showEvent(event);
+}
+
+void NotificationPanel::hideEvent(QHideEvent *event)
+{
+    m_trimTimer->start();
+    QWidget::hideEvent(event);
+}
+
+void NotificationPanel::trimMemory()
+{
+    if (isVisible() || m_trimmed) {
+        return;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    int rows = m_model->rowCount() + m_searchModel->rowCount();
+    
+    // Resetting the models closes every editor, returning the cards to the
+    // pools, which are then emptied along with the rendered row images.
+    // The text layout and blob caches are shared with the popups, so they
+    // are left to their own cost limits
+    m_historyPages.clear();
+    m_historyBoundary = -1;  // Drops any history page still loading
+    m_searchRequestId = 0;
+    m_model->clear();
+    m_searchModel->clear();
+    m_unseenIds.clear();
+    m_newPill->hide();
+    m_listView->notificationDelegate()->releaseResources();
+    m_searchView->notificationDelegate()->releaseResources();
+    m_trimmed = true;
+    
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+    // Hand the freed heap back to the system so idle RSS actually drops
+    malloc_trim(0);
+#endif
+    
+    Logger::debug(QString("Panel hidden for %1 s, released %2 rows in %3 ms")
+                 .arg(TRIM_DELAY_MS / 1000).arg(rows).arg(timer.elapsed()));
+}
+
+void NotificationPanel::restoreIfTrimmed()
+{
+    m_trimTimer->stop();
+    if (!m_trimmed) {
+        return;
+    }
+    m_trimmed = false;
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    // Only the model is rebuilt here; the view lays out and renders the
+    // visible rows on its first paint, and history pages load on scroll
+    if (m_notificationManager) {
+        m_model->resetLive(m_notificationManager->notifications());
+    }
+    m_listView->scrollToTop();
+    updateEmptyState();
+    
+    if (!m_searchField->text().trimmed().isEmpty()) {
+        onSearchTextChanged(m_searchField->text());
+    }
     
-    // Draw rounded background
-    painter.setBrush(QBrush(QColor(30, 30, 30, 230))); // Semi-transparent dark background
-    painter.setPen(QPen(QColor(255, 255, 255, 25), 1)); // Subtle border
-    painter.drawRoundedRect(rect(), 12, 12);
+    Logger::debug(QString("Panel restored %1 rows in %2 ms").arg(m_model->rowCount()).arg(timer.elapsed()));
 }
 
 int NotificationPanel::calculatePanelHeight() const
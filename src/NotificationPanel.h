@@ -3,13 +3,19 @@
 
 #include <QWidget>
 #include <QVBoxLayout>
-#include <QScrollArea>
 #include <QLabel>
 #include <QPushButton>
+#include <QLineEdit>
 #include <QPropertyAnimation>
+#include <QFutureWatcher>
+#include <QPersistentModelIndex>
+#include <QTimer>
+#include <QSet>
 #include "NotificationData.h"
+#include "HistoryStore.h"
 
-class NotificationCard;
+class NotificationListView;
+class NotificationListModel;
 
 class NotificationPanel : public QWidget
 {
@@ -23,33 +29,103 @@ public:
     void positionPanel();
     void setNotificationManager(class NotificationManager* manager);
     
+    // Rebuilds the rows from the notification manager if the panel trimmed
+    // itself while hidden; call before showing the panel
+    void restoreIfTrimmed();
+    
 public slots:
+    // Adds a card for a notification group, or updates and moves it to the top
     void addNotification(const NotificationData& notification);
+    // Applies a batch of group updates (oldest first) with a single scroll adjustment
+    void addNotifications(const QList<NotificationData>& notifications);
     void removeNotification(int notificationId);
+    void removeNotifications(const QList<int>& notificationIds);
     void clearAllNotifications();
 
+private slots:
+    void onClearClicked();
+    void onScrollValueChanged(int value);
+    void onHistoryPageLoaded();
+    void onSearchTextChanged(const QString& text);
+    void onSearchResults(quint64 requestId, const QList<HistoryRecord>& results);
+    void onRemoveRequested(const QModelIndex& index);
+    void onActionClicked(const QModelIndex& index, const QString& actionKey);
+    void onReplyRequested(const QModelIndex& index, const QString& actionKey, const QString& replyText);
+    void onNewPillClicked();
+    void trimMemory();
+
 protected:
     void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 public:
     static constexpr int PANEL_WIDTH = 350;
     static constexpr int TOP_MARGIN = 50;
     static constexpr int BOTTOM_MARGIN = 50;
     static constexpr int RIGHT_MARGIN = 20;
+    
+    // Cold tier: history pages loaded from disk below the in-memory rows
+    static constexpr int HISTORY_PAGE_SIZE = 50;
+    static constexpr int MAX_HISTORY_PAGES = 4;
+    static constexpr int HISTORY_PREFETCH_MARGIN = 400; // px from the edge of loaded content
+    static constexpr int NEW_PILL_MARGIN = 8;
+    
+    // Hidden this long, the panel drops its rows, cards and caches
+    static constexpr int TRIM_DELAY_MS = 30000;
 
 private:
-    void setupScrollArea();
+    void setupListView();
+    void setupSearchView();
+    void clearSearchResults();
     void updateEmptyState();
     int calculatePanelHeight() const;
     
+    // A page of archived notifications, covering history records [firstSeq, endSeq)
+    struct HistoryPage {
+        qint64 firstSeq;
+        qint64 endSeq;
+        int rowCount;  // Archived rows still shown for this page
+    };
+    
+    void requestHistoryPage(qint64 firstSeq, qint64 endSeq, bool prepend);
+    void removeHistoryPage(int pageIndex);
+    void clearHistoryPages();
+    int historyRowPosition(int pageIndex) const;
+    void scrollToKeep(const QPersistentModelIndex& anchor, int anchorTop);
+    
+    // Live updates while the user reads further down keep the viewport still
+    void applyLiveUpdates(const QList<NotificationData>& notifications);
+    QPersistentModelIndex firstVisibleRow(const QSet<int>& skipIds) const;
+    void clearUnseen();
+    void updateNewPill();
+    
     QVBoxLayout* m_mainLayout;
-    QScrollArea* m_scrollArea;
-    QWidget* m_scrollWidget;
-    QVBoxLayout* m_scrollLayout;
+    NotificationListView* m_listView;
+    NotificationListModel* m_model;
     QLabel* m_emptyLabel;
     QPushButton* m_clearButton;
+    QLineEdit* m_searchField;
+    
+    // Search results replace the notification list while a query is active
+    NotificationListView* m_searchView;
+    NotificationListModel* m_searchModel;
+    QLabel* m_noResultsLabel;
+    quint64 m_searchRequestId;
+    
+    QList<HistoryPage> m_historyPages;  // Newest first
+    QFutureWatcher<QList<HistoryRecord>>* m_historyWatcher;
+    qint64 m_historyBoundary;           // End of the cold tier, -1 until browsing starts
+    qint64 m_pendingFirstSeq;
+    qint64 m_pendingEndSeq;
+    bool m_pendingPrepend;
+    
+    // Groups added or updated above the viewport since the user last saw the top
+    QSet<int> m_unseenIds;
+    QPushButton* m_newPill;  // "N new", floats over the top of the list
     
-    QList<NotificationCard*> m_notificationCards;
+    QTimer* m_trimTimer;
+    bool m_trimmed;  // Rows were released; updates are ignored until restoreIfTrimmed()
     class NotificationManager* m_notificationManager;
 };
 
@@ -1,284 +1,213 @@
 #include "NotificationPopup.h"
-#include "qfontmetrics.h"
-
-#include <QHBoxLayout>
-#include <QVBoxLayout>
-#include <QLabel>
-#include <QPushButton>
+#include "BackgroundCache.h"
+#include "BlobCache.h"
+#include "CardRenderer.h"
+#include "FramePacer.h"
+#include "RelativeTimeTicker.h"
+#include "TextLayoutCache.h"
+
+#include <QEasingCurve>
 #include <QPainter>
-#include <QDateTime>
-#include <QEvent>
-#include <QEnterEvent>
-#include <QMouseEvent>
-#include <QPropertyAnimation>
-#include <QGraphicsOpacityEffect>
-#include <QApplication>
-#include <QScreen>
 
-NotificationPopup::NotificationPopup(const NotificationData& notification, QWidget *parent)
-    : QWidget(parent)
-    , m_notificationData(notification)
-    , m_mainLayout(nullptr)
-    , m_headerLayout(nullptr)
-    , m_appNameLabel(nullptr)
-    , m_timeLabel(nullptr)
-    , m_titleLabel(nullptr)
-    , m_bodyLabel(nullptr)
-    , m_closeButton(nullptr)
-    , m_autoCloseTimer(nullptr)
-    , m_showAnimation(nullptr)
-    , m_hideAnimation(nullptr)
-    , m_opacityEffect(nullptr)
-    , m_isHovered(false)
-    , m_isClosing(false)
-{
-    setupUI();
-    
-    // Set window properties
-    setWindowFlags(Qt::Tool | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint);
-    setAttribute(Qt::WA_TranslucentBackground);
-    setAttribute(Qt::WA_ShowWithoutActivating);
-    setFixedSize(POPUP_WIDTH, POPUP_HEIGHT);
-    setMouseTracking(true);
-    
-    // Setup opacity effect for animations
-    m_opacityEffect = new QGraphicsOpacityEffect(this);
-    setGraphicsEffect(m_opacityEffect);
-    m_opacityEffect->setOpacity(0.0);
-    
-    // Setup animations
-    m_showAnimation = new QPropertyAnimation(m_opacityEffect, "opacity", this);
-    m_showAnimation->setDuration(ANIMATION_DURATION);
-    m_showAnimation->setStartValue(0.0);
-    m_showAnimation->setEndValue(1.0);
-    connect(m_showAnimation, &QPropertyAnimation::finished, this, &NotificationPopup::onShowAnimationFinished);
-    
-    m_hideAnimation = new QPropertyAnimation(m_opacityEffect, "opacity", this);
-    m_hideAnimation->setDuration(ANIMATION_DURATION);
-    m_hideAnimation->setStartValue(1.0);
-    m_hideAnimation->setEndValue(0.0);
-    connect(m_hideAnimation, &QPropertyAnimation::finished, this, &NotificationPopup::onHideAnimationFinished);
-    
-    // Setup auto-close timer
-    m_autoCloseTimer = new QTimer(this);
-    m_autoCloseTimer->setSingleShot(true);
-    connect(m_autoCloseTimer, &QTimer::timeout, this, &NotificationPopup::onAutoCloseTimeout);
-}
+namespace {
 
-NotificationPopup::~NotificationPopup()
+QFont popupFont(const QFont& base, int pixelSize, bool bold)
 {
-    // QWidget destructor handles child widgets
+    QFont font(base);
+    font.setPixelSize(pixelSize);
+    font.setBold(bold);
+    return font;
 }
 
-void NotificationPopup::setupUI()
+qreal progressFor(qint64 since, int duration, qint64 now)
 {
-    m_mainLayout = new QVBoxLayout(this);
-    m_mainLayout->setContentsMargins(POPUP_MARGIN, POPUP_MARGIN, POPUP_MARGIN, POPUP_MARGIN);
-    m_mainLayout->setSpacing(POPUP_SPACING);
-    
-    // Create header layout (app name, time, close button)
-    m_headerLayout = new QHBoxLayout();
-    m_headerLayout->setSpacing(8);
-    
-    // App name label
-    m_appNameLabel = new QLabel(m_notificationData.appName, this);
-    m_appNameLabel->setStyleSheet(
-        "QLabel {"
-        "    color: rgba(255, 255, 255, 0.8);"
-        "    font-size: 12px;"
-        "    font-weight: bold;"
-        "}"
-    );
-    m_headerLayout->addWidget(m_appNameLabel);
-    
-    m_headerLayout->addStretch(); // Push time and button to the right
-    
-    // Time label
-    m_timeLabel = new QLabel(this);
-    updateTimeLabel();
-    m_timeLabel->setStyleSheet(
-        "QLabel {"
-        "    color: rgba(255, 255, 255, 0.5);"
-        "    font-size: 10px;"
-        "}"
-    );
-    m_headerLayout->addWidget(m_timeLabel);
-    
-    // Close button
-    m_closeButton = new QPushButton("×", this);
-    m_closeButton->setFixedSize(20, 20);
-    m_closeButton->setStyleSheet(
-        "QPushButton {"
-        "    background-color: transparent;"
-        "    border: none;"
-        "    color: rgba(255, 255, 255, 0.6);"
-        "    font-size: 16px;"
-        "    font-weight: bold;"
-        "    border-radius: 10px;"
-        "}"
-        "QPushButton:hover {"
-        "    background-color: rgba(255, 255, 255, 0.1);"
-        "    color: rgba(255, 255, 255, 0.9);"
-        "}"
-    );
-    connect(m_closeButton, &QPushButton::clicked, this, &NotificationPopup::onCloseClicked);
-    m_headerLayout->addWidget(m_closeButton);
-    
-    m_mainLayout->addLayout(m_headerLayout);
-    
-    // Title label
-    if (!m_notificationData.title.isEmpty()) {
-        m_titleLabel = new QLabel(m_notificationData.title, this);
-        QFontMetrics fontMetrics(m_titleLabel->font());
-        QString elidedText = fontMetrics.elidedText(m_notificationData.title, Qt::ElideRight, POPUP_WIDTH - 2 * POPUP_MARGIN);
-        m_titleLabel->setText(elidedText);
-        m_titleLabel->setWordWrap(true);
-        m_titleLabel->setStyleSheet(
-            "QLabel {"
-            "    color: white;"
-            "    font-size: 14px;"
-            "    font-weight: bold;"
-            "    margin-bottom: 4px;"
-            "}"
-        );
-        m_mainLayout->addWidget(m_titleLabel);
+    if (duration <= 0) {
+        return 1.0;
     }
-    
-    // Body label
-    if (!m_notificationData.body.isEmpty()) {
-        m_bodyLabel = new QLabel(m_notificationData.body, this);
-        QFontMetrics fontMetrics(m_bodyLabel->font());
-        QString elidedText = fontMetrics.elidedText(m_notificationData.body, Qt::ElideRight, 3 * POPUP_WIDTH - 2 * POPUP_MARGIN);
-        m_bodyLabel->setText(elidedText);
-        m_bodyLabel->setWordWrap(true);
-        m_bodyLabel->setStyleSheet(
-            "QLabel {"
-            "    color: rgba(255, 255, 255, 0.9);"
-            "    font-size: 12px;"
-            "    line-height: 1.4;"
-            "}"
-        );
-        m_mainLayout->addWidget(m_bodyLabel);
-    }
-    m_mainLayout->addStretch();
+    return qBound(0.0, (now - since) / qreal(duration), 1.0);
 }
 
-void NotificationPopup::updateTimeLabel()
+} // namespace
+
+NotificationPopup::NotificationPopup(const NotificationData& notification)
+    : m_notificationData(notification)
+    , m_moveSince(0)
+    , m_moveDuration(MOVE_DURATION)
+    , m_moving(false)
+    , m_state(State::Showing)
+    , m_stateSince(0)
+    , m_stateDuration(ANIMATION_DURATION)
+    , m_closeDeadline(-1)
+    , m_opacity(0.0)
+    , m_pulseSince(-1)
+    , m_pulseDuration(PULSE_DURATION)
+    , m_pulse(0.0)
+    , m_isHovered(false)
 {
-    if (!m_timeLabel) return;
-    
-    QDateTime now = QDateTime::currentDateTime();
-    qint64 secondsAgo = m_notificationData.timestamp.secsTo(now);
-    
-    QString timeText;
-    if (secondsAgo < 60) {
-        timeText = "now";
-    } else if (secondsAgo < 3600) {
-        timeText = QString("%1m").arg(secondsAgo / 60);
-    } else if (secondsAgo < 86400) {
-        timeText = QString("%1h").arg(secondsAgo / 3600);
-    } else {
-        timeText = QString("%1d").arg(secondsAgo / 86400);
-    }
-    
-    m_timeLabel->setText(timeText);
 }
 
-void NotificationPopup::setPosition(int x, int y)
+NotificationPopup::~NotificationPopup()
 {
-    move(x, y);
 }
 
-void NotificationPopup::startShowAnimation()
+QRect NotificationPopup::closeButtonRect() const
 {
-    show();
-    m_showAnimation->start();
+    // Matches where CardRenderer::paintContent() draws the × glyph
+    return QRect(m_position.x() + POPUP_WIDTH - POPUP_MARGIN - CLOSE_BUTTON_SIZE,
+                 m_position.y() + POPUP_MARGIN, CLOSE_BUTTON_SIZE, CLOSE_BUTTON_SIZE);
 }
 
-void NotificationPopup::paintEvent(QPaintEvent *event)
+void NotificationPopup::setPosition(const QPoint& position)
 {
-    Q_UNUSED(event)
-    
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
-    
-    // Draw popup background
-    QColor backgroundColor = m_isHovered ? 
-        QColor(60, 60, 60, 200) : QColor(45, 45, 45, 180);
-    
-    painter.setBrush(backgroundColor);
-    painter.setPen(QPen(QColor(255, 255, 255, m_isHovered ? 40 : 20), 1));
-    painter.drawRoundedRect(rect().adjusted(1, 1, -1, -1), 8, 8);
+    m_position = position;
+    m_moving = false;
 }
 
-void NotificationPopup::enterEvent(QEnterEvent *event)
+void NotificationPopup::moveTo(const QPoint& target, qint64 now)
 {
-    Q_UNUSED(event)
-    m_isHovered = true;
-    
-    // Pause auto-close timer when hovered
-    if (m_autoCloseTimer->isActive()) {
-        m_autoCloseTimer->stop();
+    if (target == targetPosition()) {
+        return;
     }
     
-    update();
-    QWidget::enterEvent(event);
+    m_moveFrom = m_position;
+    m_moveTarget = target;
+    m_moveSince = now;
+    m_moveDuration = FramePacer::instance().duration(MOVE_DURATION);
+    m_moving = true;
 }
 
-void NotificationPopup::leaveEvent(QEvent *event)
+void NotificationPopup::advanceMove(qint64 now)
 {
-    Q_UNUSED(event)
-    m_isHovered = false;
+    if (!m_moving) {
+        return;
+    }
     
-    // Resume auto-close timer when not hovered
-    if (!m_isClosing) {
-        m_autoCloseTimer->start(AUTO_CLOSE_DURATION);
+    qreal progress = progressFor(m_moveSince, m_moveDuration, now);
+    if (progress >= 1.0) {
+        setPosition(m_moveTarget);
+        return;
     }
     
-    update();
-    QWidget::leaveEvent(event);
+    static const QEasingCurve easing(QEasingCurve::OutCubic);
+    m_position = m_moveFrom + (m_moveTarget - m_moveFrom) * easing.valueForProgress(progress);
 }
 
-bool NotificationPopup::eventFilter(QObject *obj, QEvent *event)
+void NotificationPopup::pulse(qint64 now)
 {
-    Q_UNUSED(obj)
-    Q_UNUSED(event)
-    return QWidget::eventFilter(obj, event);
+    m_pulseSince = now;
+    m_pulseDuration = FramePacer::instance().duration(PULSE_DURATION);
 }
 
-void NotificationPopup::onCloseClicked()
+void NotificationPopup::advancePulse(qint64 now)
 {
-    if (!m_isClosing) {
-        startHideAnimation();
+    if (m_pulseSince < 0) {
+        return;
+    }
+    
+    qreal progress = progressFor(m_pulseSince, m_pulseDuration, now);
+    m_pulse = 1.0 - progress;
+    if (progress >= 1.0) {
+        m_pulseSince = -1;
     }
 }
 
-void NotificationPopup::onAutoCloseTimeout()
+void NotificationPopup::setNotificationData(const NotificationData& notification)
 {
-    if (!m_isClosing && !m_isHovered) {
-        startHideAnimation();
-    }
+    m_notificationData = notification;
+    invalidate();
 }
 
-void NotificationPopup::onShowAnimationFinished()
+void NotificationPopup::setHovered(bool hovered)
 {
-    // Start auto-close timer after show animation is complete
-    if (!m_isHovered) {
-        m_autoCloseTimer->start(AUTO_CLOSE_DURATION);
+    if (m_isHovered != hovered) {
+        m_isHovered = hovered;
+        invalidate();
     }
 }
 
-void NotificationPopup::onHideAnimationFinished()
+void NotificationPopup::setState(State state, qint64 now, qreal startProgress)
+{
+    m_state = state;
+    m_stateDuration = FramePacer::instance().duration(ANIMATION_DURATION);
+    m_stateSince = now - qRound(startProgress * m_stateDuration);
+}
+
+qreal NotificationPopup::stateProgress(qint64 now) const
 {
-    emit closeRequested(m_notificationData.id);
-    deleteLater();
+    return progressFor(m_stateSince, m_stateDuration, now);
 }
 
-void NotificationPopup::startHideAnimation()
+void NotificationPopup::paint(QPainter* painter, const QFont& baseFont)
 {
-    if (m_isClosing) return;
+    if (m_opacity <= 0.0) {
+        return;
+    }
+    
+    qreal dpr = painter->device() ? painter->device()->devicePixelRatio() : 1.0;
+    if (m_pixmap.isNull() || m_pixmap.devicePixelRatio() != dpr) {
+        m_pixmap = render(baseFont, dpr);
+    }
+    
+    // Fading is a blit with painter opacity rather than an offscreen effect
+    painter->setOpacity(m_opacity);
+    painter->drawPixmap(m_position, m_pixmap);
     
-    m_isClosing = true;
-    m_autoCloseTimer->stop();
-    m_hideAnimation->start();
+    // The pulse ring is a plain stroke, so it needs no cached pixmap per step
+    if (m_pulse > 0.0) {
+        painter->setRenderHint(QPainter::Antialiasing);
+        painter->setPen(QPen(QColor(255, 255, 255, qRound(180 * m_pulse)), 2));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRoundedRect(QRectF(geometry()).adjusted(1, 1, -1, -1), 8, 8);
+    }
+    painter->setOpacity(1.0);
+}
+
+QPixmap NotificationPopup::render(const QFont& baseFont, qreal devicePixelRatio) const
+{
+    QPixmap pixmap(size() * devicePixelRatio);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    pixmap.fill(Qt::transparent);
+    
+    QPainter painter(&pixmap);
+    BackgroundCache::draw(&painter, QRect(QPoint(0, 0), size()), BackgroundCache::cardStyle(m_isHovered));
+    
+    int contentWidth = POPUP_WIDTH - 2 * POPUP_MARGIN;
+    
+    CardRenderer::Content content;
+    content.id = m_notificationData.id;
+    content.appName = m_notificationData.appName;
+    content.time = RelativeTimeTicker::instance()->format(m_notificationData.timestamp);
+    content.indicator = false;
+    // Missing pictures are drawn once decoded, after the overlay invalidates the popup
+    content.hasIcon = !m_notificationData.iconHash.isEmpty();
+    content.hasImage = !m_notificationData.imageHash.isEmpty();
+    BlobCache* blobs = BlobCache::instance();
+    content.icon = blobs->image(m_notificationData.iconHash,
+                                QSize(CardRenderer::ICON_SIZE, CardRenderer::ICON_SIZE), devicePixelRatio);
+    content.image = blobs->image(m_notificationData.imageHash,
+                                 QSize(CardRenderer::IMAGE_SIZE, CardRenderer::IMAGE_SIZE), devicePixelRatio);
+    int textWidth = CardRenderer::textWidth(contentWidth, content.hasImage);
+    content.appFont = popupFont(baseFont, 12, true);
+    content.indicatorFont = popupFont(baseFont, 14, true);
+    content.removeFont = popupFont(baseFont, 16, true);
+    content.timeFont = popupFont(baseFont, 10, false);
+    content.titleFont = popupFont(baseFont, 14, true);
+    content.bodyFont = popupFont(baseFont, 12, false);
+    // Grouped popups show how many messages they stand for
+    QString title = m_notificationData.title;
+    if (m_notificationData.isGrouped()) {
+        title = QString("%1 (%2)").arg(title).arg(m_notificationData.groupCount);
+    }
+    content.title = TextLayoutCache::instance().elidedText(
+        title, content.titleFont, Qt::ElideRight, textWidth);
+    content.body = TextLayoutCache::instance().elidedText(
+        m_notificationData.getDisplayBody(), content.bodyFont, Qt::ElideRight, 3 * textWidth);
+    content.size = QSize(contentWidth, POPUP_HEIGHT - 2 * POPUP_MARGIN);
+    content.devicePixelRatio = devicePixelRatio;
+    
+    painter.translate(POPUP_MARGIN, POPUP_MARGIN);
+    CardRenderer::paintContent(&painter, content);
+    painter.end();
+    
+    return pixmap;
 }
@@ -1,73 +1,102 @@
 #ifndef NOTIFICATIONPOPUP_H
 #define NOTIFICATIONPOPUP_H
 
-#include <QWidget>
-#include <QLabel>
-#include <QPushButton>
-#include <QVBoxLayout>
-#include <QHBoxLayout>
-#include <QTimer>
-#include <QPropertyAnimation>
-#include <QGraphicsOpacityEffect>
+#include <QFont>
+#include <QPixmap>
+#include <QRect>
 #include "NotificationData.h"
 
-class NotificationPopup : public QWidget
-{
-    Q_OBJECT
+class QPainter;
 
+// One popup item hosted by a PopupOverlay. Popups are not widgets: the
+// overlay lays them out, animates them and forwards input, and each popup
+// paints itself from a cached pixmap that is rebuilt only when its content,
+// hover state or relative time changes.
+class NotificationPopup
+{
 public:
-    explicit NotificationPopup(const NotificationData& notification, QWidget *parent = nullptr);
+    enum class State {
+        Showing,  // Fading in
+        Shown,    // Waiting for auto-close
+        Closing   // Fading out; removed when the fade ends
+    };
+    
+    explicit NotificationPopup(const NotificationData& notification);
     ~NotificationPopup();
 
     int getNotificationId() const { return m_notificationData.id; }
-    void setPosition(int x, int y);
-    void startShowAnimation();
-
-signals:
-    void closeRequested(int notificationId);
-
-protected:
-    void paintEvent(QPaintEvent *event) override;
-    void enterEvent(QEnterEvent *event) override;
-    void leaveEvent(QEvent *event) override;
-    bool eventFilter(QObject *obj, QEvent *event) override;
-
-private slots:
-    void onCloseClicked();
-    void onAutoCloseTimeout();
-    void onShowAnimationFinished();
-    void onHideAnimationFinished();
-
-private:
-    void setupUI();
-    void startHideAnimation();
-    void updateTimeLabel();
+    const NotificationData& notificationData() const { return m_notificationData; }
+    void setNotificationData(const NotificationData& notification);
     
-    NotificationData m_notificationData;
+    // Geometry in screen coordinates, following any move in progress
+    QRect geometry() const { return QRect(m_position, size()); }
+    void setPosition(const QPoint& position);
     
-    QVBoxLayout* m_mainLayout;
-    QHBoxLayout* m_headerLayout;
+    // Slides to a new position on the overlay clock, from wherever it is now
+    void moveTo(const QPoint& target, qint64 now);
+    void advanceMove(qint64 now);
+    bool isMoving() const { return m_moving; }
+    QPoint targetPosition() const { return m_moving ? m_moveTarget : m_position; }
+    QRect closeButtonRect() const;
+    static QSize size() { return QSize(POPUP_WIDTH, POPUP_HEIGHT); }
     
-    QLabel* m_appNameLabel;
-    QLabel* m_timeLabel;
-    QLabel* m_titleLabel;
-    QLabel* m_bodyLabel;
-    QPushButton* m_closeButton;
+    bool isHovered() const { return m_isHovered; }
+    void setHovered(bool hovered);
     
-    QTimer* m_autoCloseTimer;
-    QPropertyAnimation* m_showAnimation;
-    QPropertyAnimation* m_hideAnimation;
-    QGraphicsOpacityEffect* m_opacityEffect;
+    // Durations are fixed when a fade, move or pulse starts, scaled by FramePacer
+    State state() const { return m_state; }
+    // startProgress resumes a fade part-way, e.g. fading out a half-shown popup
+    void setState(State state, qint64 now, qreal startProgress = 0.0);
+    // Progress of the current fade, 0 to 1
+    qreal stateProgress(qint64 now) const;
     
-    bool m_isHovered;
-    bool m_isClosing;
+    // Fade progress, 0 (transparent) to 1 (opaque)
+    qreal opacity() const { return m_opacity; }
+    void setOpacity(qreal opacity) { m_opacity = opacity; }
+    
+    // Auto-close deadline on the overlay clock, or -1 while paused
+    qint64 closeDeadline() const { return m_closeDeadline; }
+    void setCloseDeadline(qint64 deadline) { m_closeDeadline = deadline; }
+    
+    // Briefly rings the popup to draw attention to an in-place update
+    void pulse(qint64 now);
+    void advancePulse(qint64 now);
+    bool isPulsing() const { return m_pulseSince >= 0; }
+    
+    // Drops the cached pixmap, e.g. when the relative time text changes
+    void invalidate() { m_pixmap = QPixmap(); }
+    void paint(QPainter* painter, const QFont& baseFont);
     
     static constexpr int POPUP_WIDTH = 350;
     static constexpr int POPUP_HEIGHT = 120;
     static constexpr int POPUP_MARGIN = 12;
-    static constexpr int POPUP_SPACING = 8;
+    static constexpr int CLOSE_BUTTON_SIZE = 20;
     static constexpr int AUTO_CLOSE_DURATION = 5000; // 5 seconds
     static constexpr int ANIMATION_DURATION = 300;
+    static constexpr int MOVE_DURATION = 200;
+    static constexpr int PULSE_DURATION = 600;
+
+private:
+    QPixmap render(const QFont& baseFont, qreal devicePixelRatio) const;
+    
+    NotificationData m_notificationData;
+    QPoint m_position;
+    QPoint m_moveFrom;
+    QPoint m_moveTarget;
+    qint64 m_moveSince;
+    int m_moveDuration;
+    bool m_moving;
+    QPixmap m_pixmap;
+    
+    State m_state;
+    qint64 m_stateSince;
+    int m_stateDuration;
+    qint64 m_closeDeadline;
+    qreal m_opacity;
+    qint64 m_pulseSince;  // -1 when not pulsing
+    int m_pulseDuration;
+    qreal m_pulse;        // Ring strength, fades from 1 to 0
+    bool m_isHovered;
 };
 
 #endif // NOTIFICATIONPOPUP_H
@@ -1,107 +1,329 @@
 #include "NotificationPopupManager.h"
+#include "Logger.h"
+#include "PopupOverlay.h"
 
 #include <QApplication>
 #include <QScreen>
 #include <QCursor>
+#include <QSettings>
+#include <algorithm>
 
 NotificationPopupManager::NotificationPopupManager(QObject *parent)
     : QObject(parent)
+    , m_digestOverlay(nullptr)
+    , m_warmedUp(false)
+    , m_retryTimer(nullptr)
+    , m_maxVisible(DEFAULT_MAX_VISIBLE)
+    , m_perAppLimit(DEFAULT_PER_APP_LIMIT)
+    , m_perAppWindowMs(DEFAULT_PER_APP_WINDOW_SECS * 1000)
+    , m_doNotDisturb(false)
 {
+    m_clock.start();
+    
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &NotificationPopupManager::drainQueue);
+    
+    connect(qApp, &QGuiApplication::screenRemoved, this, &NotificationPopupManager::onScreenRemoved);
+    
+    loadSettings();
 }
 
 NotificationPopupManager::~NotificationPopupManager()
 {
-    // Clean up any remaining popups
-    for (NotificationPopup* popup : m_activePopups) {
-        popup->deleteLater();
+    // Overlays are top-level windows without a parent
+    for (PopupOverlay* overlay : std::as_const(m_overlays)) {
+        overlay->deleteLater();
     }
-    m_activePopups.clear();
+    m_overlays.clear();
+}
+
+void NotificationPopupManager::loadSettings()
+{
+    QSettings settings;
+    m_maxVisible = qMax(1, settings.value("popups/maxVisible", DEFAULT_MAX_VISIBLE).toInt());
+    m_perAppLimit = qMax(0, settings.value("popups/perAppLimit", DEFAULT_PER_APP_LIMIT).toInt());
+    m_perAppWindowMs = qMax(0, settings.value("popups/perAppWindowSecs", DEFAULT_PER_APP_WINDOW_SECS).toInt()) * 1000;
+    m_doNotDisturb = settings.value("popups/doNotDisturb", false).toBool();
+}
+
+void NotificationPopupManager::warmUp()
+{
+    PopupOverlay* overlay = overlayFor(getCurrentScreen());
+    if (overlay) {
+        overlay->warmUp();
+        m_warmedUp = true;
+    }
+}
+
+void NotificationPopupManager::setDoNotDisturb(bool enabled)
+{
+    if (m_doNotDisturb == enabled) {
+        return;
+    }
+    
+    m_doNotDisturb = enabled;
+    QSettings settings;
+    settings.setValue("popups/doNotDisturb", enabled);
+    Logger::info(QString("Do not disturb %1").arg(enabled ? "on" : "off"));
+    
+    // Leaving do-not-disturb shows what queued up, subject to the usual cap
+    drainQueue();
 }
 
 void NotificationPopupManager::showNotificationPopup(const NotificationData& notification)
 {
-    // Create new popup
-    NotificationPopup* popup = new NotificationPopup(notification);
+    showNotificationPopups({notification});
+}
+
+void NotificationPopupManager::showNotificationPopups(const QList<NotificationData>& notifications)
+{
+    if (notifications.isEmpty()) {
+        return;
+    }
     
-    // Connect signals
-    connect(popup, &NotificationPopup::closeRequested, 
-            this, &NotificationPopupManager::onPopupCloseRequested);
+    for (const NotificationData& notification : notifications) {
+        // A group that already has a popup on screen is updated in place; that
+        // needs no slot and does not count against the app's rate limit
+        if (!m_doNotDisturb && updateVisiblePopup(notification)) {
+            continue;
+        }
+        enqueue(notification);
+    }
+    drainQueue();
+}
+
+int NotificationPopupManager::popupPriority(const NotificationData& notification)
+{
+    // No urgency is sent by the phone, so conversations (replyable) come
+    // first, then anything with actions, then plain notices
+    if (notification.canReply) {
+        return 2;
+    }
+    if (!notification.actions.isEmpty()) {
+        return 1;
+    }
+    return 0;
+}
+
+bool NotificationPopupManager::updateVisiblePopup(const NotificationData& notification)
+{
+    for (PopupOverlay* overlay : std::as_const(m_overlays)) {
+        if (overlay->updatePopup(notification)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void NotificationPopupManager::enqueue(const NotificationData& notification)
+{
+    // Messages for a group that is already waiting join its entry
+    for (PendingPopup& entry : m_queue) {
+        if (entry.notification.getGroupKey() == notification.getGroupKey()) {
+            entry.notification.mergeWith(notification);
+            return;
+        }
+    }
     
-    // Add to active popups list
-    m_activePopups.append(popup);
+    PendingPopup pending{notification, popupPriority(notification)};
     
-    // Calculate position for the new popup
-    calculatePopupPosition(popup);
+    // Stable insert: after every entry of the same or higher priority
+    auto pos = std::find_if(m_queue.begin(), m_queue.end(), [&pending](const PendingPopup& entry) {
+        return entry.priority < pending.priority;
+    });
+    m_queue.insert(pos, pending);
     
-    // Show the popup with animation
-    popup->startShowAnimation();
+    if (m_queue.size() > MAX_QUEUED) {
+        // Drop the oldest entry of the lowest priority at the tail; it is
+        // still in the panel and stays counted in the digest
+        int lowest = m_queue.last().priority;
+        auto oldest = std::find_if(m_queue.begin(), m_queue.end(), [lowest](const PendingPopup& entry) {
+            return entry.priority == lowest;
+        });
+        ++m_droppedByApp[oldest->notification.appName];
+        m_queue.erase(oldest);
+    }
 }
 
-void NotificationPopupManager::calculatePopupPosition(NotificationPopup* popup)
+void NotificationPopupManager::drainQueue()
 {
-    QScreen* screen = getCurrentScreen();
-    if (!screen) return;
+    m_retryTimer->stop();
+    
+    if (m_doNotDisturb) {
+        updateDigest({}, 0);
+        return;
+    }
     
-    QRect screenGeometry = screen->availableGeometry();
+    qint64 now = m_clock.elapsed();
+    int freeSlots = m_maxVisible - visiblePopupCount();
+    qint64 retryAt = -1;
     
-    // Start position: top-right corner of screen
-    int x = screenGeometry.right() - popup->width() - SCREEN_MARGIN;
-    int y = screenGeometry.top() + SCREEN_MARGIN;
+    QList<NotificationData> admitted;
+    QHash<QString, int> waitingByApp;
+    int waiting = 0;
     
-    // Check for collisions with existing popups and adjust position
-    for (NotificationPopup* existingPopup : m_activePopups) {
-        if (existingPopup == popup) continue; // Skip self
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+        const QString& appName = it->notification.appName;
         
-        QRect existingRect = existingPopup->geometry();
-        QRect newRect(x, y, popup->width(), popup->height());
+        qint64 limitedUntil = rateLimitedUntil(appName, now);
+        if (limitedUntil >= 0) {
+            // Over the app's rate limit: wait silently, retry when the window moves
+            retryAt = retryAt < 0 ? limitedUntil : qMin(retryAt, limitedUntil);
+            ++it;
+            continue;
+        }
         
-        // If there's a collision, move down
-        if (newRect.intersects(existingRect)) {
-            y = existingRect.bottom() + POPUP_SPACING;
+        if (freeSlots > 0) {
+            admitted.append(it->notification);
+            m_shownByApp[appName].enqueue(now);
+            --freeSlots;
+            it = m_queue.erase(it);
+            continue;
         }
+        
+        ++waitingByApp[appName];
+        ++waiting;
+        ++it;
     }
     
-    // Ensure popup doesn't go off-screen vertically
-    if (y + popup->height() > screenGeometry.bottom() - SCREEN_MARGIN) {
-        // If we would go off-screen, start a new column to the left
-        x -= (popup->width() + POPUP_SPACING);
-        y = screenGeometry.top() + SCREEN_MARGIN;
-        
-        // Ensure we don't go off-screen horizontally either
-        if (x < screenGeometry.left() + SCREEN_MARGIN) {
-            x = screenGeometry.left() + SCREEN_MARGIN;
+    // Entries dropped from a full queue count until the queue empties
+    if (m_queue.isEmpty()) {
+        m_droppedByApp.clear();
+    }
+    for (auto it = m_droppedByApp.cbegin(); it != m_droppedByApp.cend(); ++it) {
+        waitingByApp[it.key()] += it.value();
+        waiting += it.value();
+    }
+    
+    if (!admitted.isEmpty()) {
+        PopupOverlay* overlay = overlayFor(getCurrentScreen());
+        if (overlay) {
+            if (!m_firstPopupTimer.isValid()) {
+                // Report how long the first popup of the session takes to reach the screen
+                m_firstPopupTimer.start();
+                connect(overlay, &PopupOverlay::painted, this, [this]() {
+                    Logger::info(QString("First popup painted %1 ms after admission (%2)")
+                                 .arg(m_firstPopupTimer.nsecsElapsed() / 1e6, 0, 'f', 1)
+                                 .arg(m_warmedUp ? "warm" : "cold"));
+                }, Qt::SingleShotConnection);
+            }
+            overlay->addPopups(admitted);
         }
     }
+    updateDigest(waitingByApp, waiting);
     
-    popup->setPosition(x, y);
+    if (retryAt >= 0) {
+        m_retryTimer->start(static_cast<int>(qMax<qint64>(0, retryAt - now)));
+    }
 }
 
-void NotificationPopupManager::repositionExistingPopups()
+qint64 NotificationPopupManager::rateLimitedUntil(const QString& appName, qint64 now)
 {
-    // Reposition all existing popups to fill gaps
-    QScreen* screen = getCurrentScreen();
-    if (!screen) return;
+    if (m_perAppLimit <= 0 || m_perAppWindowMs <= 0) {
+        return -1;
+    }
     
-    QRect screenGeometry = screen->availableGeometry();
+    auto it = m_shownByApp.find(appName);
+    if (it == m_shownByApp.end()) {
+        return -1;
+    }
     
-    int x = screenGeometry.right() - (m_activePopups.isEmpty() ? 0 : m_activePopups.first()->width()) - SCREEN_MARGIN;
-    int y = screenGeometry.top() + SCREEN_MARGIN;
+    QQueue<qint64>& shown = it.value();
+    while (!shown.isEmpty() && shown.head() + m_perAppWindowMs <= now) {
+        shown.dequeue();
+    }
+    if (shown.isEmpty()) {
+        m_shownByApp.erase(it);
+        return -1;
+    }
     
-    for (NotificationPopup* popup : m_activePopups) {
-        popup->setPosition(x, y);
-        y += popup->height() + POPUP_SPACING;
-        
-        // Check if we need to start a new column
-        if (y + popup->height() > screenGeometry.bottom() - SCREEN_MARGIN) {
-            x -= (popup->width() + POPUP_SPACING);
-            y = screenGeometry.top() + SCREEN_MARGIN;
-            
-            // Ensure we don't go off-screen horizontally
-            if (x < screenGeometry.left() + SCREEN_MARGIN) {
-                break; // Stop if we can't fit more columns
-            }
+    return shown.size() >= m_perAppLimit ? shown.head() + m_perAppWindowMs : -1;
+}
+
+void NotificationPopupManager::updateDigest(const QHash<QString, int>& waitingByApp, int waiting)
+{
+    if (waiting == 0) {
+        if (m_digestOverlay) {
+            m_digestOverlay->clearDigest();
+        }
+        return;
+    }
+    
+    // Busiest apps first, e.g. "Slack (12), Mail (3)"
+    QList<QPair<QString, int>> apps;
+    for (auto it = waitingByApp.cbegin(); it != waitingByApp.cend(); ++it) {
+        apps.append({it.key(), it.value()});
+    }
+    std::sort(apps.begin(), apps.end(), [](const QPair<QString, int>& a, const QPair<QString, int>& b) {
+        return a.second > b.second;
+    });
+    QStringList parts;
+    for (const auto& app : std::as_const(apps)) {
+        parts.append(QString("%1 (%2)").arg(app.first).arg(app.second));
+    }
+    
+    NotificationData digest("Relay", QString("+%1 more").arg(waiting), parts.join(", "));
+    digest.id = DIGEST_ID;
+    
+    if (!m_digestOverlay) {
+        m_digestOverlay = overlayFor(getCurrentScreen());
+    }
+    if (m_digestOverlay) {
+        m_digestOverlay->setDigest(digest);
+    }
+}
+
+int NotificationPopupManager::visiblePopupCount() const
+{
+    int count = 0;
+    for (PopupOverlay* overlay : m_overlays) {
+        count += overlay->popupCount();
+    }
+    return count;
+}
+
+void NotificationPopupManager::onPopupClosed(int notificationId)
+{
+    if (notificationId == DIGEST_ID) {
+        if (m_digestOverlay && m_digestOverlay->hasDigest()) {
+            // A new digest replaced the closed one before this arrived
+            return;
+        }
+        m_digestOverlay = nullptr;
+        if (m_doNotDisturb) {
+            return;
         }
+        
+        // Dismissing the digest dismisses what it summarized, i.e. everything
+        // not held back by a rate limit; it all remains in the panel
+        qint64 now = m_clock.elapsed();
+        m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [this, now](const PendingPopup& entry) {
+            return rateLimitedUntil(entry.notification.appName, now) < 0;
+        }), m_queue.end());
+        m_droppedByApp.clear();
+        return;
+    }
+    
+    // A slot freed up
+    drainQueue();
+}
+
+PopupOverlay* NotificationPopupManager::overlayFor(QScreen* screen)
+{
+    if (!screen) {
+        return nullptr;
+    }
+    
+    PopupOverlay* overlay = m_overlays.value(screen);
+    if (!overlay) {
+        overlay = new PopupOverlay(screen);
+        // Queued, so the queue is never drained from inside an overlay's layout pass
+        connect(overlay, &PopupOverlay::popupClosed,
+                this, &NotificationPopupManager::onPopupClosed, Qt::QueuedConnection);
+        m_overlays.insert(screen, overlay);
     }
+    return overlay;
 }
 
 QScreen* NotificationPopupManager::getCurrentScreen()
@@ -121,16 +343,15 @@ QScreen* NotificationPopupManager::getCurrentScreen()
     return screen;
 }
 
-void NotificationPopupManager::onPopupCloseRequested(int notificationId)
+void NotificationPopupManager::onScreenRemoved(QScreen* screen)
 {
-    // Find and remove the popup from active list
-    for (int i = 0; i < m_activePopups.size(); ++i) {
-        if (m_activePopups[i]->getNotificationId() == notificationId) {
-            m_activePopups.removeAt(i);
-            break;
+    // Popups on a screen that went away are simply dropped
+    PopupOverlay* overlay = m_overlays.take(screen);
+    if (overlay) {
+        if (overlay == m_digestOverlay) {
+            m_digestOverlay = nullptr;
         }
+        overlay->deleteLater();
     }
-    
-    // Reposition remaining popups to fill gaps
-    repositionExistingPopups();
+    drainQueue();
 }
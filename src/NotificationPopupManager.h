@@ -2,12 +2,24 @@
 #define NOTIFICATIONPOPUPMANAGER_H
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QList>
-#include <QTimer>
+#include <QQueue>
 #include <QScreen>
+#include <QTimer>
 #include "NotificationData.h"
-#include "NotificationPopup.h"
 
+class PopupOverlay;
+
+// Routes new notifications to the popup overlay of the screen the user is
+// on. Each screen gets at most one overlay window, created on first use.
+//
+// Arrivals pass through admission control: at most maxVisible popups are on
+// screen, the rest wait in a priority queue and are summarized by a "+N more"
+// digest popup. Apps over their rate limit, and everything while do-not-disturb
+// is on, wait silently. Queued popups are shown as slots free up. Popups are
+// one per group: further messages update the group's popup or queue entry.
 class NotificationPopupManager : public QObject
 {
     Q_OBJECT
@@ -17,19 +29,61 @@ public:
     ~NotificationPopupManager();
 
     void showNotificationPopup(const NotificationData& notification);
+    // Shows a batch of arrivals (oldest first) and positions them in one pass
+    void showNotificationPopups(const QList<NotificationData>& notifications);
+    
+    bool doNotDisturb() const { return m_doNotDisturb; }
+    void setDoNotDisturb(bool enabled);
+    
+    // Reads the popups/* settings
+    void loadSettings();
+    
+    // Prepares the overlay of the current screen ahead of the first popup
+    void warmUp();
+    
+    static constexpr int DIGEST_ID = -1;          // Notification id used by the digest popup
+    static constexpr int MAX_QUEUED = 100;        // Beyond this, the oldest lowest-priority entry is dropped
+    static constexpr int DEFAULT_MAX_VISIBLE = 5;
+    static constexpr int DEFAULT_PER_APP_LIMIT = 3;
+    static constexpr int DEFAULT_PER_APP_WINDOW_SECS = 10;
 
 private slots:
-    void onPopupCloseRequested(int notificationId);
+    void onScreenRemoved(QScreen* screen);
+    void onPopupClosed(int notificationId);
+    void drainQueue();
 
 private:
-    void calculatePopupPosition(NotificationPopup* popup);
-    void repositionExistingPopups();
+    struct PendingPopup {
+        NotificationData notification;
+        int priority;
+    };
+    
+    bool updateVisiblePopup(const NotificationData& notification);
+    void enqueue(const NotificationData& notification);
+    void updateDigest(const QHash<QString, int>& waitingByApp, int waiting);
+    // Returns the time at which the app may show another popup, or -1 if it may now
+    qint64 rateLimitedUntil(const QString& appName, qint64 now);
+    int visiblePopupCount() const;
+    static int popupPriority(const NotificationData& notification);
+    
+    PopupOverlay* overlayFor(QScreen* screen);
     QScreen* getCurrentScreen();
     
-    QList<NotificationPopup*> m_activePopups;
+    QHash<QScreen*, PopupOverlay*> m_overlays;
+    PopupOverlay* m_digestOverlay;
+    
+    QList<PendingPopup> m_queue;               // Highest priority first, then arrival order
+    QHash<QString, int> m_droppedByApp;        // Dropped from a full queue, still shown in the digest
+    QHash<QString, QQueue<qint64>> m_shownByApp; // Recent admission times per app
+    QElapsedTimer m_clock;
+    QElapsedTimer m_firstPopupTimer;           // From first arrival to its first paint
+    bool m_warmedUp;
+    QTimer* m_retryTimer;                      // Re-drains when a rate limit window expires
     
-    static constexpr int POPUP_SPACING = 10;
-    static constexpr int SCREEN_MARGIN = 20;
+    int m_maxVisible;
+    int m_perAppLimit;
+    int m_perAppWindowMs;
+    bool m_doNotDisturb;
 };
 
 #endif // NOTIFICATIONPOPUPMANAGER_H
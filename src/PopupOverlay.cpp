@@ -0,0 +1,528 @@
+#include "PopupOverlay.h"
+#include "BlobCache.h"
+#include "FramePacer.h"
+#include "Logger.h"
+#include "NotificationPopup.h"
+#include "RelativeTimeTicker.h"
+
+#include <QImage>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QRegion>
+#include <QScreen>
+#include <algorithm>
+
+PopupOverlay::PopupOverlay(QScreen* screen, QWidget *parent)
+    : QWidget(parent)
+    , m_screen(screen)
+    , m_hoveredPopup(nullptr)
+    , m_digest(nullptr)
+    , m_rows(1)
+    , m_columns(1)
+    , m_frameTimer(nullptr)
+    , m_lastFrame(0)
+    , m_autoCloseTimer(nullptr)
+{
+    setWindowFlags(Qt::Tool | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint
+                   | Qt::WindowDoesNotAcceptFocus);
+    setAttribute(Qt::WA_TranslucentBackground);
+    setAttribute(Qt::WA_ShowWithoutActivating);
+    setMouseTracking(true);
+    if (m_screen) {
+        setScreen(m_screen);
+    }
+    
+    m_clock.start();
+    
+    updateSlots();
+    if (m_screen) {
+        connect(m_screen, &QScreen::availableGeometryChanged, this, [this]() {
+            updateSlots();
+            placeFrom(0, false);
+            dropOverflow();
+            updateWindowGeometry();
+        });
+    }
+    
+    // One clock drives every fade and move; it only runs while something is animating
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_frameTimer, &QTimer::timeout, this, &PopupOverlay::onFrame);
+    
+    m_autoCloseTimer = new QTimer(this);
+    m_autoCloseTimer->setSingleShot(true);
+    connect(m_autoCloseTimer, &QTimer::timeout, this, &PopupOverlay::onAutoCloseTimeout);
+    
+    connect(RelativeTimeTicker::instance(), &RelativeTimeTicker::tick, this, [this]() {
+        for (NotificationPopup* popup : std::as_const(m_popups)) {
+            popup->invalidate();
+        }
+        update();
+    });
+    
+    // Popups render before their pictures are decoded; redraw those that show one
+    connect(BlobCache::instance(), &BlobCache::imageReady, this, [this](const QString& hash) {
+        bool changed = false;
+        for (NotificationPopup* popup : std::as_const(m_popups)) {
+            const NotificationData& data = popup->notificationData();
+            if (data.iconHash == hash || data.imageHash == hash) {
+                popup->invalidate();
+                changed = true;
+            }
+        }
+        if (changed) {
+            update();
+        }
+    });
+}
+
+PopupOverlay::~PopupOverlay()
+{
+    qDeleteAll(m_popups);
+}
+
+void PopupOverlay::warmUp()
+{
+    if (isVisible()) {
+        return;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    
+    ensurePolished();
+    create();
+    
+    // Render a throwaway popup: loads the fonts, shapes sample text and fills
+    // the nine-patch cache for both hover states
+    NotificationData sample("Relay", "Relay", "Ready");
+    NotificationPopup popup(sample);
+    popup.setOpacity(1.0);
+    QImage image(NotificationPopup::size() * devicePixelRatioF(), QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(devicePixelRatioF());
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    popup.paint(&painter, font());
+    popup.setHovered(true);
+    popup.paint(&painter, font());
+    painter.end();
+    
+    // Map the window once, fully transparent and a pixel in size, so the
+    // platform surface and backing store exist before the first popup
+    setWindowOpacity(0.0);
+    setGeometry(QRect(slotPosition(0), NotificationPopup::size()));
+    setMask(QRegion(0, 0, 1, 1));
+    show();
+    QTimer::singleShot(0, this, [this]() {
+        if (m_popups.isEmpty()) {
+            hide();
+        }
+        setWindowOpacity(1.0);
+    });
+    
+    Logger::debug(QString("Popup overlay warmed up in %1 ms").arg(timer.elapsed()));
+}
+
+void PopupOverlay::addPopups(const QList<NotificationData>& notifications)
+{
+    // New popups go into the next free slots, ahead of the digest
+    int next = m_digest ? m_popups.size() - 1 : m_popups.size();
+    qint64 now = m_clock.elapsed();
+    for (const NotificationData& notification : notifications) {
+        // Later messages of a group in the same batch fold into its popup
+        if (updatePopup(notification)) {
+            continue;
+        }
+        NotificationPopup* popup = new NotificationPopup(notification);
+        popup->setState(NotificationPopup::State::Showing, now);
+        popup->setPosition(slotPosition(next));
+        m_popups.insert(next++, popup);
+        m_popupsByGroupKey.insert(notification.getGroupKey(), popup);
+    }
+    if (m_digest) {
+        m_digest->moveTo(slotPosition(m_popups.size() - 1), now);
+    }
+    
+    dropOverflow();
+    updateWindowGeometry();
+    if (!m_popups.isEmpty() && !isVisible()) {
+        show();
+    }
+    startFrameClock();
+}
+
+bool PopupOverlay::updatePopup(const NotificationData& notification)
+{
+    NotificationPopup* popup = m_popupsByGroupKey.value(notification.getGroupKey());
+    if (!popup) {
+        return false;
+    }
+    
+    NotificationData merged = popup->notificationData();
+    merged.mergeWith(notification);
+    popup->setNotificationData(merged);
+    
+    // Restart the auto-close countdown; a popup already fading out comes back
+    qint64 now = m_clock.elapsed();
+    if (popup->state() == NotificationPopup::State::Closing) {
+        startShowing(popup);
+    } else if (popup->state() == NotificationPopup::State::Shown && !popup->isHovered()) {
+        popup->setCloseDeadline(now + NotificationPopup::AUTO_CLOSE_DURATION);
+        scheduleAutoClose();
+    }
+    
+    popup->pulse(now);
+    startFrameClock();
+    update(toLocal(popup->geometry()));
+    return true;
+}
+
+void PopupOverlay::setDigest(const NotificationData& digest)
+{
+    if (m_digest) {
+        m_digest->setNotificationData(digest);
+        // A digest that was fading out comes back when overflow builds up again
+        if (m_digest->state() == NotificationPopup::State::Closing) {
+            startShowing(m_digest);
+        }
+        update(toLocal(m_digest->geometry()));
+        return;
+    }
+    
+    m_digest = new NotificationPopup(digest);
+    m_digest->setState(NotificationPopup::State::Showing, m_clock.elapsed());
+    m_digest->setPosition(slotPosition(m_popups.size()));
+    m_popups.append(m_digest);
+    
+    dropOverflow();
+    updateWindowGeometry();
+    if (!isVisible()) {
+        show();
+    }
+    startFrameClock();
+}
+
+void PopupOverlay::clearDigest()
+{
+    if (m_digest) {
+        startClosing(m_digest);
+    }
+}
+
+void PopupOverlay::updateSlots()
+{
+    m_rows = 1;
+    m_columns = 1;
+    if (!m_screen) {
+        return;
+    }
+    
+    QRect area = m_screen->availableGeometry();
+    QSize popupSize = NotificationPopup::size();
+    m_rows = qMax(1, (area.height() - 2 * SCREEN_MARGIN + POPUP_SPACING) / (popupSize.height() + POPUP_SPACING));
+    m_columns = qMax(1, (area.width() - 2 * SCREEN_MARGIN + POPUP_SPACING) / (popupSize.width() + POPUP_SPACING));
+}
+
+QPoint PopupOverlay::slotPosition(int index) const
+{
+    if (!m_screen) {
+        return QPoint();
+    }
+    
+    QRect area = m_screen->availableGeometry();
+    QSize popupSize = NotificationPopup::size();
+    int column = index / m_rows;
+    int row = index % m_rows;
+    return QPoint(area.right() - popupSize.width() - SCREEN_MARGIN - column * (popupSize.width() + POPUP_SPACING),
+                  area.top() + SCREEN_MARGIN + row * (popupSize.height() + POPUP_SPACING));
+}
+
+void PopupOverlay::placeFrom(int index, bool animate)
+{
+    qint64 now = m_clock.elapsed();
+    for (int i = index; i < m_popups.size(); ++i) {
+        if (animate) {
+            m_popups[i]->moveTo(slotPosition(i), now);
+        } else {
+            m_popups[i]->setPosition(slotPosition(i));
+        }
+    }
+    if (animate) {
+        startFrameClock();
+    }
+}
+
+void PopupOverlay::dropOverflow()
+{
+    // Popups that do not fit anywhere are dropped rather than piled up; the
+    // newest regular popup goes first so the digest keeps its place
+    while (m_popups.size() > m_rows * m_columns) {
+        int index = m_digest ? m_popups.size() - 2 : m_popups.size() - 1;
+        NotificationPopup* popup = m_popups[qMax(0, index)];
+        Logger::debug(QString("No room for popup %1, dropping it").arg(popup->getNotificationId()));
+        removePopup(popup);
+    }
+}
+
+void PopupOverlay::updateWindowGeometry()
+{
+    if (!m_screen) {
+        return;
+    }
+    
+    // The window spans only the columns in use, including those popups are
+    // still sliding out of, keeping its backing store small
+    QRect area = m_screen->availableGeometry();
+    int left = area.right() - SCREEN_MARGIN;
+    for (NotificationPopup* popup : std::as_const(m_popups)) {
+        left = qMin(left, qMin(popup->geometry().left(), popup->targetPosition().x()));
+    }
+    QRect windowRect(left, area.top(), area.right() - left + 1, area.height());
+    if (geometry() != windowRect) {
+        setGeometry(windowRect);
+    }
+    
+    updateMask();
+    update();
+}
+
+void PopupOverlay::updateMask()
+{
+    QRegion region;
+    for (NotificationPopup* popup : std::as_const(m_popups)) {
+        region += toLocal(popup->geometry());
+    }
+    
+    if (region.isEmpty()) {
+        hide();
+        return;
+    }
+    setMask(region);
+}
+
+void PopupOverlay::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.translate(-geometry().topLeft());
+    QRect dirty = event->rect().translated(geometry().topLeft());
+    for (NotificationPopup* popup : std::as_const(m_popups)) {
+        if (popup->geometry().intersects(dirty)) {
+            popup->paint(&painter, font());
+        }
+    }
+    emit painted();
+}
+
+void PopupOverlay::onFrame()
+{
+    qint64 now = m_clock.elapsed();
+    bool moved = false;
+    
+    FramePacer::instance().recordFrame(now - m_lastFrame, frameInterval());
+    m_lastFrame = now;
+    
+    for (int i = m_popups.size() - 1; i >= 0; --i) {
+        NotificationPopup* popup = m_popups[i];
+        if (popup->isMoving()) {
+            popup->advanceMove(now);
+            moved = true;
+        }
+        popup->advancePulse(now);
+        
+        qreal progress = popup->stateProgress(now);
+        switch (popup->state()) {
+        case NotificationPopup::State::Showing:
+            popup->setOpacity(progress);
+            if (progress >= 1.0) {
+                popup->setState(NotificationPopup::State::Shown, now);
+                popup->setCloseDeadline(popup->isHovered() ? -1 : now + NotificationPopup::AUTO_CLOSE_DURATION);
+            }
+            break;
+        case NotificationPopup::State::Closing:
+            popup->setOpacity(1.0 - progress);
+            if (progress >= 1.0) {
+                // Starts the popups below sliding up; they were already
+                // visited by this backwards loop and advance next frame
+                removePopup(popup);
+                moved = true;
+            }
+            break;
+        case NotificationPopup::State::Shown:
+            break;
+        }
+    }
+    
+    if (moved) {
+        updateWindowGeometry();
+    } else {
+        update();
+    }
+    
+    bool animating = std::any_of(m_popups.cbegin(), m_popups.cend(), [](const NotificationPopup* popup) {
+        return popup->isMoving() || popup->isPulsing() || popup->state() != NotificationPopup::State::Shown;
+    });
+    if (!animating) {
+        m_frameTimer->stop();
+    }
+    scheduleAutoClose();
+}
+
+void PopupOverlay::onAutoCloseTimeout()
+{
+    qint64 now = m_clock.elapsed();
+    for (NotificationPopup* popup : std::as_const(m_popups)) {
+        if (popup->state() == NotificationPopup::State::Shown && !popup->isHovered()
+            && popup->closeDeadline() >= 0 && popup->closeDeadline() <= now) {
+            startClosing(popup);
+        }
+    }
+    scheduleAutoClose();
+}
+
+void PopupOverlay::removePopup(NotificationPopup* popup)
+{
+    int index = m_popups.indexOf(popup);
+    m_popups.removeAt(index);
+    if (popup == m_hoveredPopup) {
+        m_hoveredPopup = nullptr;
+    }
+    if (popup == m_digest) {
+        m_digest = nullptr;
+    } else {
+        auto it = m_popupsByGroupKey.find(popup->notificationData().getGroupKey());
+        if (it != m_popupsByGroupKey.end() && it.value() == popup) {
+            m_popupsByGroupKey.erase(it);
+        }
+    }
+    emit popupClosed(popup->getNotificationId());
+    delete popup;
+    
+    // Only the popups after the gap move
+    placeFrom(index, true);
+}
+
+void PopupOverlay::startShowing(NotificationPopup* popup)
+{
+    // Fade in from the current opacity
+    popup->setState(NotificationPopup::State::Showing, m_clock.elapsed(), popup->opacity());
+    popup->setCloseDeadline(-1);
+    startFrameClock();
+}
+
+void PopupOverlay::startClosing(NotificationPopup* popup)
+{
+    if (popup->state() == NotificationPopup::State::Closing) {
+        return;
+    }
+    
+    // Start the fade-out from the current opacity, so interrupting a fade-in does not jump
+    popup->setState(NotificationPopup::State::Closing, m_clock.elapsed(), 1.0 - popup->opacity());
+    popup->setCloseDeadline(-1);
+    startFrameClock();
+}
+
+void PopupOverlay::startFrameClock()
+{
+    if (!m_frameTimer->isActive()) {
+        m_lastFrame = m_clock.elapsed();
+        m_frameTimer->start(frameInterval());
+    }
+}
+
+void PopupOverlay::scheduleAutoClose()
+{
+    // A single timer armed for the earliest deadline covers every popup
+    qint64 earliest = -1;
+    for (NotificationPopup* popup : std::as_const(m_popups)) {
+        if (popup->state() == NotificationPopup::State::Shown && popup->closeDeadline() >= 0) {
+            if (earliest < 0 || popup->closeDeadline() < earliest) {
+                earliest = popup->closeDeadline();
+            }
+        }
+    }
+    
+    if (earliest < 0) {
+        m_autoCloseTimer->stop();
+        return;
+    }
+    m_autoCloseTimer->start(static_cast<int>(qMax<qint64>(0, earliest - m_clock.elapsed())));
+}
+
+NotificationPopup* PopupOverlay::popupAt(const QPoint& pos) const
+{
+    for (NotificationPopup* popup : m_popups) {
+        if (popup->geometry().contains(pos)) {
+            return popup;
+        }
+    }
+    return nullptr;
+}
+
+void PopupOverlay::setHoveredPopup(NotificationPopup* popup)
+{
+    if (popup == m_hoveredPopup) {
+        return;
+    }
+    
+    qint64 now = m_clock.elapsed();
+    if (m_hoveredPopup) {
+        // Leaving a popup restarts its auto-close countdown
+        m_hoveredPopup->setHovered(false);
+        if (m_hoveredPopup->state() == NotificationPopup::State::Shown) {
+            m_hoveredPopup->setCloseDeadline(now + NotificationPopup::AUTO_CLOSE_DURATION);
+        }
+        update(toLocal(m_hoveredPopup->geometry()));
+    }
+    
+    m_hoveredPopup = popup;
+    if (m_hoveredPopup) {
+        // Hovering pauses auto-close
+        m_hoveredPopup->setHovered(true);
+        m_hoveredPopup->setCloseDeadline(-1);
+        update(toLocal(m_hoveredPopup->geometry()));
+    }
+    scheduleAutoClose();
+}
+
+void PopupOverlay::mouseMoveEvent(QMouseEvent *event)
+{
+    setHoveredPopup(popupAt(event->position().toPoint() + geometry().topLeft()));
+    QWidget::mouseMoveEvent(event);
+}
+
+void PopupOverlay::mousePressEvent(QMouseEvent *event)
+{
+    QPoint pos = event->position().toPoint() + geometry().topLeft();
+    NotificationPopup* popup = popupAt(pos);
+    if (popup && event->button() == Qt::LeftButton && popup->closeButtonRect().contains(pos)) {
+        startClosing(popup);
+        return;
+    }
+    QWidget::mousePressEvent(event);
+}
+
+void PopupOverlay::leaveEvent(QEvent *event)
+{
+    setHoveredPopup(nullptr);
+    QWidget::leaveEvent(event);
+}
+
+void PopupOverlay::showEvent(QShowEvent *event)
+{
+    RelativeTimeTicker::instance()->subscribe(this);
+    QWidget::showEvent(event);
+}
+
+void PopupOverlay::hideEvent(QHideEvent *event)
+{
+    RelativeTimeTicker::instance()->unsubscribe(this);
+    QWidget::hideEvent(event);
+}
+
+int PopupOverlay::frameInterval() const
+{
+    if (!m_screen || m_screen->refreshRate() <= 0) {
+        return FALLBACK_FRAME_INTERVAL;
+    }
+    return qMax(1, qRound(1000.0 / m_screen->refreshRate()));
+}
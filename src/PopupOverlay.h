@@ -0,0 +1,103 @@
+#ifndef POPUPOVERLAY_H
+#define POPUPOVERLAY_H
+
+#include <QWidget>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include "NotificationData.h"
+
+class NotificationPopup;
+class QScreen;
+
+// Transparent, always-on-top window that hosts every popup on one screen.
+// All popups share its backing store and one frame clock; the window mask
+// covers just the popups, so clicks elsewhere reach the windows below.
+//
+// Popups fill fixed slots, column by column from the top-right corner, and
+// keep their positions in screen coordinates. Adding a popup places only the
+// new one; removing one slides just the popups after it up by a slot.
+class PopupOverlay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PopupOverlay(QScreen* screen, QWidget *parent = nullptr);
+    ~PopupOverlay();
+
+    QScreen* targetScreen() const { return m_screen; }
+    // Regular popups on this overlay, not counting the digest
+    int popupCount() const { return m_popups.size() - (m_digest ? 1 : 0); }
+    
+    // Adds popups (oldest first) below the existing ones and fades them in
+    void addPopups(const QList<NotificationData>& notifications);
+    
+    // Creates the native window and backing store and warms fonts and
+    // background caches, so the first real popup paints without that cost
+    void warmUp();
+    
+    // Merges the notification into the popup of its group, if one is on this
+    // overlay, restarting its auto-close and pulsing it; false otherwise
+    bool updatePopup(const NotificationData& notification);
+    
+    // Shows or updates the summary popup kept at the bottom of the stack
+    void setDigest(const NotificationData& digest);
+    void clearDigest();
+    bool hasDigest() const { return m_digest != nullptr; }
+
+signals:
+    void popupClosed(int notificationId);
+    void painted();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void onFrame();
+    void onAutoCloseTimeout();
+
+private:
+    void updateSlots();
+    QPoint slotPosition(int index) const;
+    // Moves the popups from index onwards into their slots
+    void placeFrom(int index, bool animate);
+    void dropOverflow();
+    // Fits the window to the popups (current and target positions) and updates the mask
+    void updateWindowGeometry();
+    void updateMask();
+    QRect toLocal(const QRect& screenRect) const { return screenRect.translated(-geometry().topLeft()); }
+    void startShowing(NotificationPopup* popup);
+    void startClosing(NotificationPopup* popup);
+    void removePopup(NotificationPopup* popup);
+    void setHoveredPopup(NotificationPopup* popup);
+    void startFrameClock();
+    void scheduleAutoClose();
+    NotificationPopup* popupAt(const QPoint& pos) const;
+    int frameInterval() const;
+    
+    QPointer<QScreen> m_screen;
+    QList<NotificationPopup*> m_popups;
+    NotificationPopup* m_hoveredPopup;
+    NotificationPopup* m_digest;  // Always the last entry of m_popups when set
+    QHash<QString, NotificationPopup*> m_popupsByGroupKey;
+    int m_rows;                   // Slots per column
+    int m_columns;
+    
+    QElapsedTimer m_clock;
+    QTimer* m_frameTimer;
+    qint64 m_lastFrame;           // Clock time of the previous frame, for FramePacer
+    QTimer* m_autoCloseTimer;
+    
+    static constexpr int POPUP_SPACING = 10;
+    static constexpr int SCREEN_MARGIN = 20;
+    static constexpr int FALLBACK_FRAME_INTERVAL = 16; // ms, when the refresh rate is unknown
+};
+
+#endif // POPUPOVERLAY_H
@@ -0,0 +1,98 @@
+#include "RelativeTimeTicker.h"
+
+#include <QCoreApplication>
+
+RelativeTimeTicker* RelativeTimeTicker::instance()
+{
+    static RelativeTimeTicker* ticker = new RelativeTimeTicker(QCoreApplication::instance());
+    return ticker;
+}
+
+RelativeTimeTicker::RelativeTimeTicker(QObject *parent)
+    : QObject(parent)
+    , m_timer(nullptr)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &RelativeTimeTicker::onTimeout);
+}
+
+QString RelativeTimeTicker::format(const QDateTime& timestamp)
+{
+    qint64 secondsAgo = qMax<qint64>(0, timestamp.secsTo(QDateTime::currentDateTime()));
+    
+    // Bucket by the unit that is shown, so equal texts share one string
+    qint64 key;
+    if (secondsAgo < 60) {
+        key = 0;
+    } else if (secondsAgo < 3600) {
+        key = secondsAgo / 60;
+    } else if (secondsAgo < 86400) {
+        key = 100 + secondsAgo / 3600;
+    } else {
+        key = 1000 + secondsAgo / 86400;
+    }
+    
+    auto it = m_strings.constFind(key);
+    if (it != m_strings.constEnd()) {
+        return it.value();
+    }
+    
+    QString text;
+    if (key == 0) {
+        text = "now";
+    } else if (key < 100) {
+        text = QString("%1m ago").arg(key);
+    } else if (key < 1000) {
+        text = QString("%1h ago").arg(key - 100);
+    } else {
+        text = QString("%1d ago").arg(key - 1000);
+    }
+    m_strings.insert(key, text);
+    return text;
+}
+
+void RelativeTimeTicker::subscribe(QObject* subscriber)
+{
+    if (!subscriber || m_subscribers.contains(subscriber)) {
+        return;
+    }
+    
+    m_subscribers.insert(subscriber);
+    connect(subscriber, &QObject::destroyed, this, [this, subscriber]() {
+        unsubscribe(subscriber);
+    });
+    
+    if (!m_timer->isActive()) {
+        scheduleNext();
+    }
+}
+
+void RelativeTimeTicker::unsubscribe(QObject* subscriber)
+{
+    if (!m_subscribers.remove(subscriber)) {
+        return;
+    }
+    disconnect(subscriber, &QObject::destroyed, this, nullptr);
+    
+    if (m_subscribers.isEmpty()) {
+        m_timer->stop();
+    }
+}
+
+void RelativeTimeTicker::scheduleNext()
+{
+    qint64 msIntoMinute = QDateTime::currentMSecsSinceEpoch() % 60000;
+    m_timer->start(static_cast<int>(60000 - msIntoMinute) + TICK_SLACK_MS);
+}
+
+void RelativeTimeTicker::onTimeout()
+{
+    if (m_subscribers.isEmpty()) {
+        return;
+    }
+    
+    emit tick();
+    scheduleNext();
+}
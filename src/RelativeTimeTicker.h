@@ -0,0 +1,45 @@
+#ifndef RELATIVETIMETICKER_H
+#define RELATIVETIMETICKER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+// One app-wide, minute-aligned clock for relative timestamps ("5m ago").
+// Widgets showing times subscribe while they are visible and refresh on
+// tick(); with no visible subscribers the timer is stopped, so a hidden
+// panel causes no wakeups.
+class RelativeTimeTicker : public QObject
+{
+    Q_OBJECT
+
+public:
+    static RelativeTimeTicker* instance();
+
+    // Relative text for a timestamp, shared across rows with the same age
+    QString format(const QDateTime& timestamp);
+    
+    void subscribe(QObject* subscriber);
+    void unsubscribe(QObject* subscriber);
+    
+    static constexpr int TICK_SLACK_MS = 50; // Fire just after the minute turns
+
+signals:
+    void tick();
+
+private slots:
+    void onTimeout();
+
+private:
+    explicit RelativeTimeTicker(QObject *parent = nullptr);
+    
+    void scheduleNext();
+    
+    QTimer* m_timer;
+    QSet<QObject*> m_subscribers;
+    QHash<qint64, QString> m_strings; // Keyed by unit and count, e.g. "5m ago"
+};
+
+#endif // RELATIVETIMETICKER_H
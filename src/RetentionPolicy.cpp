@@ -0,0 +1,18 @@
+#include "RetentionPolicy.h"
+
+#include <QSettings>
+
+RetentionPolicy RetentionPolicy::fromSettings()
+{
+    RetentionPolicy policy;
+    QSettings settings;
+    
+    settings.beginGroup("retention");
+    policy.maxNotifications = qMax(0, settings.value("maxNotifications", policy.maxNotifications).toInt());
+    policy.maxPerApp = qMax(0, settings.value("maxPerApp", policy.maxPerApp).toInt());
+    policy.maxAgeSecs = qMax<qint64>(0, settings.value("maxAgeSecs", policy.maxAgeSecs).toLongLong());
+    policy.maxMemoryBytes = qMax<qint64>(0, settings.value("maxMemoryBytes", policy.maxMemoryBytes).toLongLong());
+    settings.endGroup();
+    
+    return policy;
+}
@@ -0,0 +1,22 @@
+#ifndef RETENTIONPOLICY_H
+#define RETENTIONPOLICY_H
+
+#include <QtGlobal>
+
+// Limits applied to the in-memory notification store. A value of 0 disables
+// the corresponding limit.
+struct RetentionPolicy {
+    int maxNotifications;   // Total number of notification groups kept
+    int maxPerApp;          // Number of notification groups kept per app
+    qint64 maxAgeSecs;      // Groups not updated for this long are dropped
+    qint64 maxMemoryBytes;  // Approximate memory budget for stored data
+    
+    RetentionPolicy()
+        : maxNotifications(100), maxPerApp(30),
+          maxAgeSecs(3 * 24 * 3600), maxMemoryBytes(4 * 1024 * 1024) {}
+    
+    // Defaults overridden by the "retention/*" keys in the application settings
+    static RetentionPolicy fromSettings();
+};
+
+#endif // RETENTIONPOLICY_H
@@ -0,0 +1,298 @@
+#include "SearchIndex.h"
+#include "Logger.h"
+
+#include <QElapsedTimer>
+#include <QSet>
+#include <QThread>
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+SearchIndex::SearchIndex(HistoryStore* history, QObject *parent)
+    : QObject(parent)
+    , m_history(history)
+    , m_thread(nullptr)
+    , m_worker(nullptr)
+    , m_minSeq(0)
+    , m_nextRequestId(1)
+    , m_latestRequestId(0)
+{
+    m_thread = new QThread(this);
+    m_thread->setObjectName("SearchIndex");
+
+    m_worker = new QObject();
+    m_worker->moveToThread(m_thread);
+    connect(m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+
+    m_thread->start(QThread::LowPriority);
+}
+
+SearchIndex::~SearchIndex()
+{
+    m_thread->quit();
+    m_thread->wait();
+}
+
+void SearchIndex::build()
+{
+    // Capture the range now; anything appended later arrives via addDocument()
+    qint64 firstSeq = m_history->firstSequence();
+    qint64 endSeq = m_history->endSequence();
+
+    QMetaObject::invokeMethod(m_worker, [this, firstSeq, endSeq]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        for (qint64 seq = firstSeq; seq < endSeq; seq += BUILD_CHUNK_SIZE) {
+            int count = static_cast<int>(qMin<qint64>(BUILD_CHUNK_SIZE, endSeq - seq));
+            const QList<HistoryRecord> records = m_history->read(seq, count);
+            for (const HistoryRecord& record : records) {
+                indexDocument(record.seq, record.notification);
+            }
+        }
+
+        Logger::debug(QString("Indexed %1 history records (%2 terms) in %3 ms")
+                      .arg(endSeq - firstSeq).arg(m_postings.size()).arg(timer.elapsed()));
+    }, Qt::QueuedConnection);
+}
+
+void SearchIndex::addDocument(qint64 seq, const NotificationData& notification)
+{
+    if (seq < 0) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(m_worker, [this, seq, notification]() {
+        indexDocument(seq, notification);
+    }, Qt::QueuedConnection);
+}
+
+void SearchIndex::removeBefore(qint64 seq)
+{
+    QMetaObject::invokeMethod(m_worker, [this, seq]() {
+        m_minSeq = qMax(m_minSeq, seq);
+
+        // Posting lists are ascending, so compaction only trims their fronts
+        for (auto it = m_postings.begin(); it != m_postings.end();) {
+            QList<qint64>& postings = it.value();
+            auto keep = std::lower_bound(postings.begin(), postings.end(), m_minSeq);
+            postings.erase(postings.begin(), keep);
+            if (postings.isEmpty()) {
+                it = m_postings.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }, Qt::QueuedConnection);
+}
+
+void SearchIndex::removeDocument(qint64 seq, const NotificationData& notification)
+{
+    if (seq < 0) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(m_worker, [this, seq, notification]() {
+        const QSet<QString> tokens = documentTokens(notification);
+        for (const QString& token : tokens) {
+            auto it = m_postings.find(token);
+            if (it == m_postings.end()) {
+                continue;
+            }
+            QList<qint64>& postings = it.value();
+            auto pos = std::lower_bound(postings.begin(), postings.end(), seq);
+            if (pos != postings.end() && *pos == seq) {
+                postings.erase(pos);
+            }
+            if (postings.isEmpty()) {
+                m_postings.erase(it);
+            }
+        }
+    }, Qt::QueuedConnection);
+}
+
+quint64 SearchIndex::search(const QString& query, int limit)
+{
+    quint64 requestId = m_nextRequestId++;
+    m_latestRequestId.storeRelease(requestId);
+
+    QMetaObject::invokeMethod(m_worker, [this, requestId, query, limit]() {
+        // Skip queries superseded while they were queued (fast typing)
+        if (requestId != m_latestRequestId.loadAcquire()) {
+            return;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        // The history skips records it can no longer return (holes left by
+        // failed writes, records compacted meanwhile), so fetch more until
+        // limit results are found or the matches run out
+        QList<HistoryRecord> results;
+        int fetch = limit;
+        forever {
+            const QList<qint64> sequences = runQuery(query, fetch);
+            results = m_history->read(sequences);
+            if (results.size() >= limit || sequences.size() < fetch) {
+                break;
+            }
+            fetch *= 2;
+        }
+        results.resize(qMin<qsizetype>(results.size(), limit));
+
+        // Never the query itself; people search for codes and messages
+        Logger::debug(QString("Search: %1 results in %2 us").arg(results.size()).arg(timer.nsecsElapsed() / 1000));
+
+        QMetaObject::invokeMethod(this, [this, requestId, results]() {
+            emit resultsReady(requestId, results);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+
+    return requestId;
+}
+
+QSet<QString> SearchIndex::documentTokens(const NotificationData& notification)
+{
+    QSet<QString> tokens;
+    auto addTokens = [&tokens](const QString& text) {
+        const QStringList words = tokenize(text);
+        for (const QString& word : words) {
+            tokens.insert(word);
+        }
+    };
+
+    addTokens(notification.appName);
+    addTokens(notification.title);
+    addTokens(notification.body);
+    for (const QString& bodyText : notification.bodies) {
+        addTokens(bodyText);
+    }
+    return tokens;
+}
+
+void SearchIndex::indexDocument(qint64 seq, const NotificationData& notification)
+{
+    if (seq < m_minSeq) {
+        return;
+    }
+
+    const QSet<QString> tokens = documentTokens(notification);
+    for (const QString& token : tokens) {
+        QList<qint64>& postings = m_postings[token];
+        // Documents normally arrive in sequence order; keep the list sorted if not
+        if (postings.isEmpty() || postings.last() < seq) {
+            postings.append(seq);
+        } else {
+            auto pos = std::lower_bound(postings.begin(), postings.end(), seq);
+            if (pos == postings.end() || *pos != seq) {
+                postings.insert(pos, seq);
+            }
+        }
+    }
+}
+
+QList<qint64> SearchIndex::runQuery(const QString& query, int limit) const
+{
+    QList<qint64> results;
+
+    QStringList terms = tokenize(query);
+    if (terms.isEmpty() || limit <= 0) {
+        return results;
+    }
+
+    // While typing, the last word is incomplete and matched as a prefix
+    QString prefix;
+    bool typingLastWord = !query.isEmpty() && !query.back().isSpace();
+    if (typingLastWord && terms.last().size() >= MIN_PREFIX_LENGTH) {
+        prefix = terms.takeLast();
+    }
+
+    // Every complete word must match exactly
+    QList<const QList<qint64>*> required;
+    for (const QString& term : std::as_const(terms)) {
+        auto it = m_postings.constFind(term);
+        if (it == m_postings.constEnd()) {
+            return results;
+        }
+        required.append(&it.value());
+    }
+    std::sort(required.begin(), required.end(), [](const QList<qint64>* a, const QList<qint64>* b) {
+        return a->size() < b->size();
+    });
+
+    auto matchesRequired = [&required](qint64 seq, int skip) {
+        for (int i = skip; i < required.size(); ++i) {
+            if (!std::binary_search(required[i]->cbegin(), required[i]->cend(), seq)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    if (prefix.isEmpty()) {
+        // Drive from the shortest list, newest first
+        const QList<qint64>& driver = *required.first();
+        for (auto it = driver.crbegin(); it != driver.crend() && results.size() < limit; ++it) {
+            if (*it >= m_minSeq && matchesRequired(*it, 1)) {
+                results.append(*it);
+            }
+        }
+        return results;
+    }
+
+    // Merge the posting lists of every word starting with the prefix from
+    // their newest end, stopping as soon as enough results are found
+    using Cursor = std::pair<qint64, std::pair<const QList<qint64>*, qsizetype>>;
+    std::priority_queue<Cursor> heap;
+    for (auto it = m_postings.lowerBound(prefix); it != m_postings.constEnd() && it.key().startsWith(prefix); ++it) {
+        const QList<qint64>& postings = it.value();
+        if (!postings.isEmpty()) {
+            heap.push({postings.last(), {&postings, postings.size() - 1}});
+        }
+    }
+
+    qint64 lastSeq = -1;
+    while (!heap.empty() && results.size() < limit) {
+        Cursor cursor = heap.top();
+        heap.pop();
+
+        qint64 seq = cursor.first;
+        if (seq < m_minSeq) {
+            continue;
+        }
+        if (seq != lastSeq && matchesRequired(seq, 0)) {
+            results.append(seq);
+        }
+        lastSeq = seq;
+
+        qsizetype next = cursor.second.second - 1;
+        if (next >= 0) {
+            heap.push({cursor.second.first->at(next), {cursor.second.first, next}});
+        }
+    }
+
+    return results;
+}
+
+QStringList SearchIndex::tokenize(const QString& text)
+{
+    QStringList tokens;
+    QString current;
+
+    const QString folded = text.toCaseFolded();
+    for (const QChar& ch : folded) {
+        if (ch.isLetterOrNumber()) {
+            current.append(ch);
+        } else if (!current.isEmpty()) {
+            if (current.size() <= MAX_TOKEN_LENGTH) {
+                tokens.append(current);
+            }
+            current.clear();
+        }
+    }
+    if (!current.isEmpty() && current.size() <= MAX_TOKEN_LENGTH) {
+        tokens.append(current);
+    }
+
+    return tokens;
+}
@@ -0,0 +1,69 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QAtomicInteger>
+#include "HistoryStore.h"
+
+class QThread;
+
+// Incrementally maintained inverted index over the notification history.
+//
+// Every history record is tokenized (title, body, grouped bodies, app name)
+// into case-folded words. Posting lists hold ascending history sequence
+// numbers, so results come out newest first by walking them backwards.
+// All index state lives on a dedicated thread; the public methods only
+// post work to it and results come back through resultsReady().
+class SearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SearchIndex(HistoryStore* history, QObject *parent = nullptr);
+    ~SearchIndex();
+
+    // Indexes every record currently in the history
+    void build();
+    void addDocument(qint64 seq, const NotificationData& notification);
+    // Drops a record deleted from the history; notification is its content
+    void removeDocument(qint64 seq, const NotificationData& notification);
+    
+    // Starts a query and returns its request ID. The last word is matched as
+    // a prefix so results update while the user is still typing.
+    quint64 search(const QString& query, int limit = DEFAULT_LIMIT);
+    
+    static constexpr int DEFAULT_LIMIT = 100;
+    static constexpr int MIN_PREFIX_LENGTH = 2;
+    static constexpr int MAX_TOKEN_LENGTH = 64;
+    static constexpr int BUILD_CHUNK_SIZE = 1000;
+
+public slots:
+    // Drops every document older than seq (history compaction)
+    void removeBefore(qint64 seq);
+
+signals:
+    void resultsReady(quint64 requestId, const QList<HistoryRecord>& results);
+
+private:
+    // Worker thread only
+    void indexDocument(qint64 seq, const NotificationData& notification);
+    static QSet<QString> documentTokens(const NotificationData& notification);
+    QList<qint64> runQuery(const QString& query, int limit) const;
+    static QStringList tokenize(const QString& text);
+    
+    HistoryStore* m_history;
+    QThread* m_thread;
+    QObject* m_worker;  // Context object living on m_thread
+    
+    QMap<QString, QList<qint64>> m_postings;
+    qint64 m_minSeq;
+    
+    quint64 m_nextRequestId;
+    QAtomicInteger<quint64> m_latestRequestId;
+};
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,55 @@
+#include "TextLayoutCache.h"
+
+#include <QFontMetrics>
+
+TextLayoutCache& TextLayoutCache::instance()
+{
+    static TextLayoutCache cache;
+    return cache;
+}
+
+TextLayoutCache::TextLayoutCache()
+    : m_heights(MAX_HEIGHTS)
+    , m_elided(MAX_ELIDED)
+{
+}
+
+QRect TextLayoutCache::wrappedRect(const QString& text, const QFont& font, int width)
+{
+    // Tall enough never to clip; only the width constrains the layout
+    return QFontMetrics(font).boundingRect(QRect(0, 0, width, 1 << 20), WRAP_FLAGS, text);
+}
+
+int TextLayoutCache::height(const QString& text, const QFont& font, int width)
+{
+    if (text.isEmpty()) {
+        return 0;
+    }
+    
+    Key key{text, font.key(), width, -1};
+    if (int* cached = m_heights.object(key)) {
+        return *cached;
+    }
+    
+    int height = wrappedRect(text, font, width).height();
+    m_heights.insert(key, new int(height));
+    return height;
+}
+
+QString TextLayoutCache::elidedText(const QString& text, const QFont& font, Qt::TextElideMode mode, int width)
+{
+    Key key{text, font.key(), width, static_cast<int>(mode)};
+    if (QString* cached = m_elided.object(key)) {
+        return *cached;
+    }
+    
+    QString elided = QFontMetrics(font).elidedText(text, mode, width);
+    m_elided.insert(key, new QString(elided));
+    return elided;
+}
+
+void TextLayoutCache::clear()
+{
+    m_heights.clear();
+    m_elided.clear();
+}
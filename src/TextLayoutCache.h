@@ -0,0 +1,53 @@
+#ifndef TEXTLAYOUTCACHE_H
+#define TEXTLAYOUTCACHE_H
+
+#include <QCache>
+#include <QFont>
+#include <QRect>
+#include <QString>
+#include <QHashFunctions>
+
+// Caches wrapped text heights and elided strings keyed by text, font and
+// width, so relayouts and resizes of the same notification do not measure
+// the same text again. GUI thread only, except wrappedRect().
+class TextLayoutCache
+{
+public:
+    static TextLayoutCache& instance();
+
+    // Bounds of plain text wrapped at word boundaries, as drawText() lays it
+    // out with WRAP_FLAGS. Rows are measured and painted with this, so a
+    // painted card always fits its row. Thread-safe, not cached.
+    static QRect wrappedRect(const QString& text, const QFont& font, int width);
+    int height(const QString& text, const QFont& font, int width);
+    QString elidedText(const QString& text, const QFont& font, Qt::TextElideMode mode, int width);
+    
+    void clear();
+    
+    static constexpr int WRAP_FLAGS = Qt::AlignLeft | Qt::AlignTop | Qt::TextWordWrap;
+    static constexpr int MAX_HEIGHTS = 2048;
+    static constexpr int MAX_ELIDED = 512;
+
+private:
+    TextLayoutCache();
+    
+    struct Key {
+        QString text;
+        QString font;  // QFont::key()
+        int width;
+        int mode;      // Elide mode, -1 for wrapped layouts
+        
+        bool operator==(const Key& other) const {
+            return width == other.width && mode == other.mode
+                && font == other.font && text == other.text;
+        }
+        friend size_t qHash(const Key& key, size_t seed = 0) {
+            return qHashMulti(seed, key.text, key.font, key.width, key.mode);
+        }
+    };
+    
+    QCache<Key, int> m_heights;
+    QCache<Key, QString> m_elided;
+};
+
+#endif // TEXTLAYOUTCACHE_H
@@ -0,0 +1,164 @@
+#include "UpdateBatcher.h"
+#include "Logger.h"
+
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QHash>
+#include <QScreen>
+#include <QSet>
+#include <QSettings>
+#include <algorithm>
+#include <numeric>
+
+UpdateBatcher::UpdateBatcher(QObject *parent)
+    : QObject(parent)
+    , m_flushTimer(nullptr)
+    , m_cleared(false)
+{
+    // Started by the first change of a batch and never restarted, so a
+    // steady stream still reaches the UI within the latency bound
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setTimerType(Qt::PreciseTimer);
+    m_flushTimer->setInterval(frameInterval());
+    connect(m_flushTimer, &QTimer::timeout, this, &UpdateBatcher::flush);
+}
+
+UpdateBatcher::~UpdateBatcher()
+{
+}
+
+void UpdateBatcher::setMaxLatency(int msecs)
+{
+    m_flushTimer->setInterval(msecs > 0 ? msecs : frameInterval());
+}
+
+int UpdateBatcher::maxLatencyFromSettings()
+{
+    QSettings settings;
+    return qMax(0, settings.value("ui/maxLatencyMs", 0).toInt());
+}
+
+int UpdateBatcher::frameInterval()
+{
+    QScreen* screen = QGuiApplication::primaryScreen();
+    if (!screen || screen->refreshRate() <= 0) {
+        return FALLBACK_FRAME_INTERVAL;
+    }
+    return qMax(1, qRound(1000.0 / screen->refreshRate()));
+}
+
+void UpdateBatcher::addReceived(const NotificationData& notification)
+{
+    m_received.append(notification);
+    scheduleFlush();
+}
+
+void UpdateBatcher::addUpdated(const NotificationData& notification)
+{
+    m_updated.append(notification);
+    scheduleFlush();
+}
+
+void UpdateBatcher::addRemoved(int notificationId)
+{
+    m_removed.append(notificationId);
+    scheduleFlush();
+}
+
+void UpdateBatcher::addCleared()
+{
+    // Anything pending for the panel is superseded by the clear
+    m_updated.clear();
+    m_removed.clear();
+    m_cleared = true;
+    scheduleFlush();
+}
+
+void UpdateBatcher::scheduleFlush()
+{
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void UpdateBatcher::flush()
+{
+    m_flushTimer->stop();
+    
+    QElapsedTimer timer;
+    timer.start();
+    int changeCount = m_received.size() + m_updated.size() + m_removed.size();
+    
+    // Group IDs are never reused, so an update for a removed group is stale
+    QSet<int> removed(m_removed.cbegin(), m_removed.cend());
+    
+    // Keep the last update per group; later updates also moved it to the top
+    QList<NotificationData> updated;
+    QSet<int> seenIds;
+    for (auto it = m_updated.crbegin(); it != m_updated.crend(); ++it) {
+        if (!removed.contains(it->id) && !seenIds.contains(it->id)) {
+            seenIds.insert(it->id);
+            updated.append(*it);
+        }
+    }
+    std::reverse(updated.begin(), updated.end());
+    
+    // One popup per group per batch, with every message of the batch merged
+    // in oldest first so the popup shows the newest and counts the rest
+    QList<NotificationData> received;
+    QList<int> lastArrival;
+    QHash<QString, int> groupRows;
+    for (int i = 0; i < m_received.size(); ++i) {
+        const NotificationData& notification = m_received[i];
+        auto found = groupRows.constFind(notification.getGroupKey());
+        if (found == groupRows.constEnd()) {
+            groupRows.insert(notification.getGroupKey(), received.size());
+            received.append(notification);
+            lastArrival.append(i);
+        } else {
+            received[found.value()].mergeWith(notification);
+            lastArrival[found.value()] = i;
+        }
+    }
+    
+    // A group that got another message later in the batch pops up later
+    if (received.size() > 1) {
+        QList<int> order(received.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&lastArrival](int a, int b) {
+            return lastArrival[a] < lastArrival[b];
+        });
+        QList<NotificationData> sorted;
+        sorted.reserve(received.size());
+        for (int row : std::as_const(order)) {
+            sorted.append(received[row]);
+        }
+        received.swap(sorted);
+    }
+    
+    bool cleared = m_cleared;
+    QList<int> removedIds = m_removed;
+    m_received.clear();
+    m_updated.clear();
+    m_removed.clear();
+    m_cleared = false;
+    
+    if (cleared) {
+        emit notificationsCleared();
+    }
+    if (!removedIds.isEmpty()) {
+        emit notificationsRemoved(removedIds);
+    }
+    if (!updated.isEmpty()) {
+        emit notificationsUpdated(updated);
+    }
+    if (!received.isEmpty()) {
+        emit notificationsReceived(received);
+    }
+    
+    if (changeCount > 1) {
+        Logger::debug(QString("Applied %1 batched changes in %2 us")
+                      .arg(changeCount).arg(timer.nsecsElapsed() / 1000));
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef UPDATEBATCHER_H
+#define UPDATEBATCHER_H
+
+#include <QObject>
+#include <QList>
+#include <QTimer>
+#include "NotificationData.h"
+
+// Sits between NotificationManager and the UI and coalesces its signals, so a
+// burst of arrivals costs one panel update, one scroll adjustment and one
+// popup decision instead of one of each per notification.
+class UpdateBatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UpdateBatcher(QObject *parent = nullptr);
+    ~UpdateBatcher();
+
+    // Longest time a change may wait before it reaches the UI; 0 means one display frame
+    void setMaxLatency(int msecs);
+    int maxLatency() const { return m_flushTimer->interval(); }
+    
+    // Reads ui/maxLatencyMs from QSettings
+    static int maxLatencyFromSettings();
+    
+    static constexpr int FALLBACK_FRAME_INTERVAL = 16; // ms, when the refresh rate is unknown
+
+public slots:
+    void addReceived(const NotificationData& notification);
+    void addUpdated(const NotificationData& notification);
+    void addRemoved(int notificationId);
+    void addCleared();
+    void flush();
+
+signals:
+    // Arrivals, one per group with the batch's messages merged into it,
+    // ordered by each group's newest arrival, oldest first
+    void notificationsReceived(const QList<NotificationData>& notifications);
+    // Merged groups, oldest first, at most one per group ID
+    void notificationsUpdated(const QList<NotificationData>& notifications);
+    void notificationsRemoved(const QList<int>& notificationIds);
+    void notificationsCleared();
+
+private:
+    void scheduleFlush();
+    static int frameInterval();
+    
+    QTimer* m_flushTimer;
+    QList<NotificationData> m_received;
+    QList<NotificationData> m_updated;
+    QList<int> m_removed;
+    bool m_cleared;
+};
+
+#endif // UPDATEBATCHER_H
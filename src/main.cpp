@@ -1,5 +1,6 @@
 #include <QApplication>
 #include <QDebug>
+#include <QFile>
 #include "MainWindow.h"
 #include "NotificationManager.h"
 #include "NotificationClient.h"
@@ -14,6 +15,14 @@ int main(int argc, char *argv[])
     app.setApplicationVersion("1.0");
     app.setOrganizationName("RelayPC");
     
+    // One application-wide stylesheet, parsed once instead of per widget
+    QFile styleFile(":/styles.qss");
+    if (styleFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        app.setStyleSheet(QString::fromUtf8(styleFile.readAll()));
+    } else {
+        Logger::warning("Could not load application stylesheet");
+    }
+    
     MainWindow window;
     
     // Parse command line arguments